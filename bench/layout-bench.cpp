@@ -0,0 +1,117 @@
+#include "staticbitmapset.h"
+#include "staticset.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+/* Compares lookup latency and memory footprint of the available layouts, and of StaticBitmapSet, over integer sets of
+ * increasing sparsity, i.e. (max - min) / size, to show where the bitmap stops paying for itself */
+
+static std::default_random_engine generator;
+
+static const size_t set_size = 1 << 20;
+static const size_t query_count = 1 << 22;
+
+static std::vector<int> generateSparseVector(size_t count, size_t sparsity) {
+  std::uniform_int_distribution<size_t> distribution(0, sparsity - 1);
+
+  std::vector<int> data;
+
+  for (size_t i = 0; data.size() < count; i++) {
+    if (distribution(generator) == 0) {
+      data.push_back(static_cast<int>(i));
+    }
+  }
+
+  return data;
+}
+
+template <class Query> static double nanosecondsPerQuery(const std::vector<int> &queries, Query query) {
+  const auto start = std::chrono::steady_clock::now();
+
+  size_t checksum = 0;
+  for (const int needle : queries) {
+    checksum += query(needle);
+  }
+
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  /* Keep the compiler from discarding the queries */
+  volatile size_t sink = checksum;
+  (void)sink;
+
+  return std::chrono::duration<double, std::nano>(elapsed).count() / queries.size();
+}
+
+static const char *layoutName(StaticSetLayout layout) {
+  switch (layout) {
+  case StaticSetLayout::Automatic:
+    return "automatic";
+  case StaticSetLayout::Tree:
+    return "tree";
+  case StaticSetLayout::Partitioned:
+    return "partitioned";
+  }
+  return "?";
+}
+
+template <class Set>
+static void report(size_t sparsity, const char *name, const Set &ss, const std::vector<int> &queries, bool automatic) {
+  const double contains = nanosecondsPerQuery(queries, [&](int needle) { return ss.contains(needle); });
+
+  const double lower = nanosecondsPerQuery(queries, [&](int needle) {
+    const auto it = ss.lowerBound(needle);
+    return ((it == ss.end()) ? 0 : *it);
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  size_t checksum = 0;
+  for (const int value : ss) {
+    checksum += value;
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  volatile size_t sink = checksum;
+  (void)sink;
+  const double iterate = std::chrono::duration<double, std::nano>(elapsed).count() / ss.size();
+
+  std::printf("%9zu  %-12s %10.2f %12.1f %12.1f %12.2f%s\n", sparsity, name,
+              static_cast<double>(ss.memoryUsage()) / ss.size(), contains, lower, iterate,
+              (automatic ? "  (automatic)" : ""));
+}
+
+int main(void) {
+  const StaticSetLayout layouts[] = {StaticSetLayout::Tree, StaticSetLayout::Partitioned};
+
+  std::printf("%9s  %-12s %10s %12s %12s %12s\n", "sparsity", "layout", "bytes/elem", "contains ns", "lower ns",
+              "iterate ns");
+
+  for (size_t sparsity = 1; sparsity <= 512; sparsity *= 2) {
+    const std::vector<int> data = generateSparseVector(set_size, sparsity);
+
+    std::uniform_int_distribution<int> distribution(data.front(), data.back());
+    std::vector<int> queries(query_count);
+    for (auto &query : queries) {
+      query = distribution(generator);
+    }
+
+    const StaticSetLayout automatic = StaticSet<int>(data.begin(), data.end()).layout();
+
+    for (const StaticSetLayout layout : layouts) {
+      const StaticSet<int> ss(data.begin(), data.end(), layout);
+
+      if (ss.layout() == layout) {
+        report(sparsity, layoutName(layout), ss, queries, (layout == automatic));
+      }
+    }
+
+    try {
+      report(sparsity, "bitmap", StaticBitmapSet<int>(data.begin(), data.end()), queries, false);
+    } catch (const std::invalid_argument &) {
+      /* Too sparse for a bitmap */
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,711 @@
+#ifndef LIBSTATICSET_EXTERNALSTATICSET_H
+#define LIBSTATICSET_EXTERNALSTATICSET_H
+
+#include "staticset.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Layout of a search tree file written by StaticSetBuilder. The header is followed immediately by the elements of the
+ * set in Eytzinger order, i.e. exactly the array a StaticSet with the Tree layout would hold in memory */
+struct StaticSetFileHeader {
+  static const uint32_t current_version = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t element_size;
+  uint64_t size;
+
+  /* Pad to a cache line so that the elements are suitably aligned in a mapping */
+  char reserved[40];
+
+  static const char *expectedMagic() { return "SSETREE"; }
+};
+
+/* A non-owning, read-only view of an Eytzinger-ordered array of distinct elements, such as the contents of a file
+ * written by StaticSetBuilder. Supports the same queries and ordered iteration as StaticSet */
+template <class T, class Compare = std::less<T>> class StaticSetView : private StaticSetTree {
+protected:
+  Compare compare;
+  const T *tree;
+  size_t n;
+
+  explicit StaticSetView(const Compare &comp) : compare(comp), tree(nullptr), n(0) { ; }
+
+  size_t bound(const T &needle, bool strict) const { return boundIndex(tree, n, needle, strict, compare); }
+
+public:
+  class OrderedIterator {
+    friend class StaticSetView;
+
+    const StaticSetView<T, Compare> *view;
+    size_t index;
+
+    OrderedIterator(const StaticSetView<T, Compare> &view, size_t index) : view(&view), index(index) { ; }
+
+  public:
+    typedef size_t difference_type;
+    typedef T value_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+    typedef std::bidirectional_iterator_tag iterator_category;
+
+    reference operator*() const {
+      assert(index < view->n);
+      return view->tree[index];
+    }
+
+    pointer operator->() const { return &**this; }
+
+    bool operator==(const OrderedIterator &other) const { return (view == other.view && index == other.index); }
+
+    bool operator!=(const OrderedIterator &other) const { return !(*this == other); }
+
+    OrderedIterator &operator++() {
+      assert(index < view->n);
+      index = successor(index, view->n);
+      return *this;
+    }
+
+    OrderedIterator operator++(int) {
+      OrderedIterator prev = *this;
+      ++(*this);
+      return prev;
+    }
+
+    OrderedIterator &operator--() {
+      assert(*this != view->begin());
+      index = ((index == view->n) ? digRight(0, view->n) : predecessor(index, view->n));
+      return *this;
+    }
+
+    OrderedIterator operator--(int) {
+      OrderedIterator prev = *this;
+      --(*this);
+      return prev;
+    }
+  };
+
+  StaticSetView(const T *tree, size_t size, const Compare &comp = Compare()) : compare(comp), tree(tree), n(size) {
+    ;
+  }
+
+  size_t size() const { return n; }
+
+  bool empty() const { return (n == 0); }
+
+  Compare valueComp() const { return compare; }
+
+  Compare value_comp() const { return valueComp(); }
+
+  OrderedIterator begin() const { return OrderedIterator(*this, ((n == 0) ? 0 : digLeft(0, n))); }
+
+  OrderedIterator end() const { return OrderedIterator(*this, n); }
+
+  const T *ubegin() const { return tree; }
+
+  const T *uend() const { return tree + n; }
+
+  bool contains(const T &needle) const { return (find(needle) != end()); }
+
+  OrderedIterator find(const T &needle) const {
+    const size_t index = bound(needle, false);
+    return ((index == n || compare(needle, tree[index])) ? end() : OrderedIterator(*this, index));
+  }
+
+  OrderedIterator lower_bound(const T &needle) const { return OrderedIterator(*this, bound(needle, false)); }
+
+  OrderedIterator lowerBound(const T &needle) const { return lower_bound(needle); }
+
+  OrderedIterator upper_bound(const T &needle) const { return OrderedIterator(*this, bound(needle, true)); }
+
+  OrderedIterator upperBound(const T &needle) const { return upper_bound(needle); }
+};
+
+/* A search tree file written by StaticSetBuilder, mapped read-only into memory. Pages are loaded on demand, so the
+ * file may be much larger than physical memory */
+template <class T, class Compare = std::less<T>> class MappedStaticSet : public StaticSetView<T, Compare> {
+  void *mapping;
+  size_t mapping_size;
+
+  static int openReadOnly(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+      throw std::system_error(errno, std::generic_category(), "open " + path);
+    }
+    return fd;
+  }
+
+public:
+  explicit MappedStaticSet(const std::string &path, const Compare &comp = Compare())
+      : MappedStaticSet(openReadOnly(path), path, comp) {
+    ;
+  }
+
+  /* Map a search tree from a descriptor open for reading, such as a shared memory object, taking ownership of the
+   * descriptor. The path is used only in error messages */
+  MappedStaticSet(int fd, const std::string &path, const Compare &comp = Compare())
+      : StaticSetView<T, Compare>(comp), mapping(MAP_FAILED), mapping_size(0) {
+    struct stat status;
+    if (fstat(fd, &status) == -1) {
+      const int error = errno;
+      close(fd);
+      throw std::system_error(error, std::generic_category(), "stat " + path);
+    }
+
+    mapping_size = status.st_size;
+
+    if (mapping_size >= sizeof(StaticSetFileHeader)) {
+      mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+
+    const int error = errno;
+    close(fd);
+
+    if (mapping_size < sizeof(StaticSetFileHeader)) {
+      throw std::runtime_error(path + ": truncated header");
+    }
+
+    if (mapping == MAP_FAILED) {
+      throw std::system_error(error, std::generic_category(), "mmap " + path);
+    }
+
+    const StaticSetFileHeader &header = *static_cast<const StaticSetFileHeader *>(mapping);
+
+    if (std::memcmp(header.magic, StaticSetFileHeader::expectedMagic(), sizeof(header.magic)) != 0 ||
+        header.version != StaticSetFileHeader::current_version || header.element_size != sizeof(T) ||
+        mapping_size != sizeof(StaticSetFileHeader) + header.size * sizeof(T)) {
+      munmap(mapping, mapping_size);
+      throw std::runtime_error(path + ": not a search tree file for this element type");
+    }
+
+    this->tree = reinterpret_cast<const T *>(static_cast<const char *>(mapping) + sizeof(StaticSetFileHeader));
+    this->n = header.size;
+  }
+
+  MappedStaticSet(const MappedStaticSet &other) = delete;
+
+  MappedStaticSet(MappedStaticSet &&other)
+      : StaticSetView<T, Compare>(other), mapping(other.mapping), mapping_size(other.mapping_size) {
+    other.mapping = MAP_FAILED;
+    other.tree = nullptr;
+    other.n = 0;
+  }
+
+  MappedStaticSet &operator=(const MappedStaticSet &other) = delete;
+
+  MappedStaticSet &operator=(MappedStaticSet &&other) = delete;
+
+  ~MappedStaticSet() {
+    if (mapping != MAP_FAILED) {
+      munmap(mapping, mapping_size);
+    }
+  }
+};
+
+enum class StaticSetBuildPhase { RunFormation, Merge, Layout, Done };
+
+/* Progress and throughput counters for a StaticSetBuilder, reported periodically while building */
+struct StaticSetBuildProgress {
+  StaticSetBuildPhase phase;
+
+  /* Elements consumed from the input, including duplicates */
+  uint64_t elements_read;
+
+  /* Sorted runs spilled to temporary files, and merge passes performed over them */
+  uint64_t runs_written;
+  uint64_t merge_passes;
+
+  /* Distinct elements written to the output so far; the size of the set once the build is done */
+  uint64_t elements_written;
+
+  /* Disk traffic, including temporary files */
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+
+  /* Wall-clock time since the builder was created */
+  double seconds;
+
+  double elementsReadPerSecond() const { return ((seconds > 0) ? elements_read / seconds : 0); }
+
+  double bytesPerSecond() const { return ((seconds > 0) ? (bytes_read + bytes_written) / seconds : 0); }
+};
+
+/* Builds a search tree file for MappedStaticSet from input too large to hold in memory, using at most (roughly) the
+ * given number of bytes of buffer space. Input is consumed in chunks, sorted into runs which are spilled to temporary
+ * files next to the output, and merged (in several passes if need be) into a single sorted, deduplicated run. A final
+ * pass then scatters that run into the breadth-first order of the tree, one buffered stream per level */
+template <class T, class Compare = std::less<T>> class StaticSetBuilder : private StaticSetTree {
+  static_assert(std::is_trivially_copyable<T>::value, "StaticSetBuilder requires trivially copyable elements");
+
+  /* Memory is carved into this many blocks for merging, one of which buffers output */
+  static const size_t merge_blocks = 64;
+
+  /* Report progress at least this often, in elements */
+  static const uint64_t progress_interval = 1 << 20;
+
+  /* Input files are read through a staging area of this many elements */
+  static const size_t staging_size = 4096;
+
+  /* Uninitialized room for one element. Elements are trivially copyable, so may be read from disk straight into it,
+   * without T having to be default-constructible */
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+  class RunReader {
+    std::FILE *file;
+    std::vector<Slot> buffer;
+    size_t filled;
+    size_t position;
+    StaticSetBuildProgress &progress;
+
+  public:
+    RunReader(const std::string &path, size_t block_size, StaticSetBuildProgress &progress)
+        : file(std::fopen(path.c_str(), "rb")), buffer(block_size), filled(0), position(0), progress(progress) {
+      if (file == nullptr) {
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+      }
+    }
+
+    RunReader(const RunReader &other) = delete;
+
+    ~RunReader() { std::fclose(file); }
+
+    /* Returns a pointer to the next element, or nullptr at the end of the run */
+    const T *peek() {
+      if (position == filled) {
+        filled = std::fread(buffer.data(), sizeof(T), buffer.size(), file);
+        if (filled == 0 && std::ferror(file)) {
+          throw std::system_error(errno, std::generic_category(), "read run");
+        }
+        position = 0;
+        progress.bytes_read += filled * sizeof(T);
+      }
+
+      return ((position == filled) ? nullptr : reinterpret_cast<const T *>(&buffer[position]));
+    }
+
+    void pop() { position++; }
+  };
+
+  class RunWriter {
+    std::FILE *file;
+    std::vector<T> buffer;
+    StaticSetBuildProgress &progress;
+
+  public:
+    RunWriter(const std::string &path, size_t block_size, StaticSetBuildProgress &progress)
+        : file(std::fopen(path.c_str(), "wb")), progress(progress) {
+      if (file == nullptr) {
+        throw std::system_error(errno, std::generic_category(), "create " + path);
+      }
+      buffer.reserve(block_size);
+    }
+
+    RunWriter(const RunWriter &other) = delete;
+
+    ~RunWriter() {
+      if (file != nullptr) {
+        std::fclose(file);
+      }
+    }
+
+    void push(const T &value) {
+      buffer.push_back(value);
+      if (buffer.size() == buffer.capacity()) {
+        flush();
+      }
+    }
+
+    /* Write the given values straight to the file, after anything already buffered */
+    void write(const T *values, size_t count) {
+      flush();
+      if (std::fwrite(values, sizeof(T), count, file) != count) {
+        throw std::system_error(errno, std::generic_category(), "write run");
+      }
+      progress.bytes_written += count * sizeof(T);
+    }
+
+    void flush() {
+      if (std::fwrite(buffer.data(), sizeof(T), buffer.size(), file) != buffer.size()) {
+        throw std::system_error(errno, std::generic_category(), "write run");
+      }
+      progress.bytes_written += buffer.size() * sizeof(T);
+      buffer.clear();
+    }
+
+    void close() {
+      flush();
+      const int result = std::fclose(file);
+      file = nullptr;
+      if (result != 0) {
+        throw std::system_error(errno, std::generic_category(), "close run");
+      }
+    }
+  };
+
+  const std::string path;
+  const size_t memory_budget;
+  const Compare compare;
+
+  std::vector<T> buffer;
+  std::vector<std::string> runs;
+  size_t next_run_id;
+
+  /* The number of elements in the most recently spilled run */
+  uint64_t last_run_size;
+
+  StaticSetBuildProgress current;
+  std::function<void(const StaticSetBuildProgress &)> callback;
+  uint64_t last_reported;
+  const std::chrono::steady_clock::time_point started;
+
+  size_t blockSize(size_t blocks) const { return std::max<size_t>(1, memory_budget / sizeof(T) / blocks); }
+
+  bool equivalent(const T &x, const T &y) const { return (!compare(x, y) && !compare(y, x)); }
+
+  void report(bool force = false) {
+    const uint64_t processed = current.elements_read + current.elements_written;
+
+    if (!force && processed - last_reported < progress_interval) {
+      return;
+    }
+
+    last_reported = processed;
+    current.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    if (callback) {
+      callback(current);
+    }
+  }
+
+  std::string runPath() { return path + ".run" + std::to_string(next_run_id++); }
+
+  /* Sort, deduplicate and spill the in-memory buffer. Both happen in place, so that the buffer can take up the whole
+   * memory budget */
+  void spill() {
+    if (buffer.empty()) {
+      return;
+    }
+
+    std::sort(buffer.begin(), buffer.end(), compare);
+    buffer.erase(std::unique(buffer.begin(), buffer.end(), [&](const T &x, const T &y) { return equivalent(x, y); }),
+                 buffer.end());
+
+    const std::string run = runPath();
+    RunWriter writer(run, 1, current);
+    runs.push_back(run);
+
+    writer.write(buffer.data(), buffer.size());
+    writer.close();
+
+    last_run_size = buffer.size();
+    buffer.clear();
+
+    current.runs_written++;
+    report(true);
+  }
+
+  /* Merge the given runs into a single sorted, deduplicated run, returning the number of elements written */
+  uint64_t merge(const std::vector<std::string> &inputs, const std::string &output) {
+    const size_t block_size = blockSize(merge_blocks);
+
+    std::vector<std::unique_ptr<RunReader>> readers;
+    for (const std::string &input : inputs) {
+      readers.emplace_back(new RunReader(input, block_size, current));
+    }
+
+    /* Min-heap of readers, ordered by their next element */
+    const auto later = [&](size_t x, size_t y) { return compare(*readers[y]->peek(), *readers[x]->peek()); };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+
+    for (size_t i = 0; i < readers.size(); i++) {
+      if (readers[i]->peek() != nullptr) {
+        heap.push(i);
+      }
+    }
+
+    RunWriter writer(output, block_size, current);
+    uint64_t written = 0;
+
+    /* Each run is free of duplicates, so any others of the smallest element are at the fronts of other runs, and
+     * hence at the top of the heap */
+    while (!heap.empty()) {
+      const size_t i = heap.top();
+      heap.pop();
+
+      const T value = *readers[i]->peek();
+      writer.push(value);
+      written++;
+
+      for (size_t j = i;;) {
+        readers[j]->pop();
+
+        if (readers[j]->peek() != nullptr) {
+          heap.push(j);
+        }
+
+        if (heap.empty() || !equivalent(*readers[heap.top()]->peek(), value)) {
+          break;
+        }
+
+        j = heap.top();
+        heap.pop();
+      }
+    }
+
+    writer.close();
+    readers.clear();
+
+    for (const std::string &input : inputs) {
+      std::remove(input.c_str());
+    }
+
+    return written;
+  }
+
+  /* Write the sorted run of the given size to the output file in Eytzinger order. Elements on any one level of the
+   * tree appear in sorted order, so walking the tree in order while appending each element to its level's buffer
+   * turns the scatter into one sequential stream per level */
+  void layout(const std::string &sorted, uint64_t size) {
+    const std::string temporary = path + ".tmp";
+
+    const int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+      throw std::system_error(errno, std::generic_category(), "create " + temporary);
+    }
+
+    const auto fail = [&](const std::string &what) {
+      const int error = errno;
+      close(fd);
+      std::remove(temporary.c_str());
+      throw std::system_error(error, std::generic_category(), what + " " + temporary);
+    };
+
+    const auto writeAt = [&](const void *data, size_t length, uint64_t offset) {
+      const char *bytes = static_cast<const char *>(data);
+      while (length > 0) {
+        const ssize_t count = pwrite(fd, bytes, length, offset);
+        if (count == -1) {
+          if (errno == EINTR) {
+            continue;
+          }
+          fail("write");
+        }
+        bytes += count;
+        length -= count;
+        offset += count;
+        current.bytes_written += count;
+      }
+    };
+
+    if (ftruncate(fd, sizeof(StaticSetFileHeader) + size * sizeof(T)) == -1) {
+      fail("truncate");
+    }
+
+    size_t levels = 0;
+    while ((uint64_t(1) << levels) - 1 < size) {
+      levels++;
+    }
+
+    const size_t block_size = blockSize(levels + 1);
+    std::vector<std::vector<T>> level_buffers(levels);
+    std::vector<uint64_t> level_written(levels, 0);
+
+    const auto flush = [&](size_t level) {
+      const uint64_t first = (uint64_t(1) << level) - 1 + level_written[level];
+      writeAt(level_buffers[level].data(), level_buffers[level].size() * sizeof(T),
+              sizeof(StaticSetFileHeader) + first * sizeof(T));
+      level_written[level] += level_buffers[level].size();
+      level_buffers[level].clear();
+    };
+
+    for (auto &level_buffer : level_buffers) {
+      level_buffer.reserve(block_size);
+    }
+
+    RunReader reader(sorted, block_size, current);
+    size_t index = ((size == 0) ? 0 : digLeft(0, size));
+
+    for (const T *value; (value = reader.peek()) != nullptr; reader.pop()) {
+      assert(index < size);
+
+      size_t level = 0;
+      while ((uint64_t(2) << level) - 1 <= index) {
+        level++;
+      }
+
+      level_buffers[level].push_back(*value);
+      if (level_buffers[level].size() == block_size) {
+        flush(level);
+      }
+
+      index = successor(index, size);
+      current.elements_written++;
+      report();
+    }
+
+    assert(index == size);
+
+    for (size_t level = 0; level < levels; level++) {
+      flush(level);
+    }
+
+    StaticSetFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, StaticSetFileHeader::expectedMagic(), sizeof(header.magic));
+    header.version = StaticSetFileHeader::current_version;
+    header.element_size = sizeof(T);
+    header.size = size;
+    writeAt(&header, sizeof(header), 0);
+
+    if (fsync(fd) == -1) {
+      fail("sync");
+    }
+
+    if (close(fd) == -1) {
+      std::remove(temporary.c_str());
+      throw std::system_error(errno, std::generic_category(), "close " + temporary);
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+      throw std::system_error(errno, std::generic_category(), "rename " + temporary);
+    }
+  }
+
+public:
+  StaticSetBuilder(const std::string &path, size_t memory_budget, const Compare &comp = Compare())
+      : path(path), memory_budget(memory_budget), compare(comp), next_run_id(0), last_run_size(0), current(),
+        last_reported(0),
+        started(std::chrono::steady_clock::now()) {
+    buffer.reserve(blockSize(1));
+    current.phase = StaticSetBuildPhase::RunFormation;
+  }
+
+  StaticSetBuilder(const StaticSetBuilder &other) = delete;
+
+  StaticSetBuilder &operator=(const StaticSetBuilder &other) = delete;
+
+  ~StaticSetBuilder() {
+    for (const std::string &run : runs) {
+      std::remove(run.c_str());
+    }
+  }
+
+  /* Register a function to be called with progress counters after every spilled run or merge pass, every million or
+   * so elements otherwise, and once the build is done */
+  void onProgress(std::function<void(const StaticSetBuildProgress &)> progress_callback) {
+    callback = progress_callback;
+  }
+
+  void insert(const T &value) {
+    assert(current.phase == StaticSetBuildPhase::RunFormation);
+
+    buffer.push_back(value);
+    current.elements_read++;
+
+    if (buffer.size() == buffer.capacity()) {
+      spill();
+    }
+  }
+
+  template <class Iter> void insert(Iter first, Iter last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  /* Consume a file holding a raw array of elements, in chunks */
+  void insertFile(const std::string &input) {
+    assert(current.phase == StaticSetBuildPhase::RunFormation);
+
+    std::FILE *file = std::fopen(input.c_str(), "rb");
+    if (file == nullptr) {
+      throw std::system_error(errno, std::generic_category(), "open " + input);
+    }
+
+    std::vector<Slot> staging(std::min(size_t(staging_size), buffer.capacity()));
+    const T *staged = reinterpret_cast<const T *>(staging.data());
+
+    for (;;) {
+      const size_t wanted = std::min(staging.size(), buffer.capacity() - buffer.size());
+      const size_t count = std::fread(staging.data(), sizeof(T), wanted, file);
+      buffer.insert(buffer.end(), staged, staged + count);
+
+      current.elements_read += count;
+      current.bytes_read += count * sizeof(T);
+
+      if (buffer.size() == buffer.capacity()) {
+        spill();
+      }
+
+      if (count < wanted) {
+        break;
+      }
+    }
+
+    const bool failed = std::ferror(file);
+    std::fclose(file);
+
+    if (failed) {
+      throw std::system_error(EIO, std::generic_category(), "read " + input);
+    }
+  }
+
+  /* Write the output file. The builder can't be used further afterwards */
+  const StaticSetBuildProgress &finish() {
+    assert(current.phase == StaticSetBuildPhase::RunFormation);
+
+    spill();
+    buffer = std::vector<T>();
+
+    current.phase = StaticSetBuildPhase::Merge;
+
+    /* A lone spilled run is already sorted and deduplicated. Otherwise merge; even with no input at all, this
+     * produces one (empty) run for the layout pass */
+    const size_t fan_in = merge_blocks - 1;
+    uint64_t size = last_run_size;
+
+    while (runs.size() != 1) {
+      std::vector<std::string> next;
+
+      for (size_t i = 0; i < runs.size() || (runs.empty() && i == 0); i += fan_in) {
+        const std::vector<std::string> inputs(runs.begin() + std::min(i, runs.size()),
+                                              runs.begin() + std::min(i + fan_in, runs.size()));
+        const std::string output = runPath();
+        size = merge(inputs, output);
+        next.push_back(output);
+      }
+
+      runs = next;
+      current.merge_passes++;
+      report(true);
+    }
+
+    current.phase = StaticSetBuildPhase::Layout;
+    layout(runs[0], size);
+
+    std::remove(runs[0].c_str());
+    runs.clear();
+
+    current.phase = StaticSetBuildPhase::Done;
+    report(true);
+
+    return current;
+  }
+
+  const StaticSetBuildProgress &progress() const { return current; }
+};
+
+#endif
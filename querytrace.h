@@ -0,0 +1,282 @@
+#ifndef LIBSTATICSET_QUERYTRACE_H
+#define LIBSTATICSET_QUERYTRACE_H
+
+#include "externalstaticset.h"
+#include "staticset.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+/* Query traces record the lookups made against a StaticSet, so that realistic workloads can be replayed offline
+ * against a snapshot of the set (see tools/replay.cpp). A trace is a header followed by one record per query: the
+ * operation (one byte), the time elapsed since the previous query in nanoseconds (a LEB128 varint), and the raw bytes
+ * of the key */
+
+enum class QueryOp : uint8_t {
+  Contains,
+  Find,
+  LowerBound,
+  UpperBound,
+  Predecessor,
+  Successor,
+  Floor,
+  Ceiling,
+  Nearest
+};
+
+enum class QueryTraceKeyKind : uint32_t { Other, Signed, Unsigned, Floating };
+
+struct QueryTraceHeader {
+  static const uint32_t current_version = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t key_size;
+  QueryTraceKeyKind key_kind;
+  uint32_t reserved;
+
+  static const char *expectedMagic() { return "SSTRACE"; }
+
+  template <class T> static QueryTraceKeyKind kindOf() {
+    return (std::is_floating_point<T>::value
+                ? QueryTraceKeyKind::Floating
+                : (std::is_integral<T>::value
+                       ? (std::is_signed<T>::value ? QueryTraceKeyKind::Signed : QueryTraceKeyKind::Unsigned)
+                       : QueryTraceKeyKind::Other));
+  }
+};
+
+template <class T> struct QueryTraceRecord {
+  /* Nanoseconds since the start of the trace */
+  uint64_t timestamp;
+  QueryOp op;
+  T key;
+};
+
+/* Appends queries to a trace file. Not thread-safe; give each thread its own writer */
+template <class T> class QueryTraceWriter {
+  static_assert(std::is_trivially_copyable<T>::value, "query traces require trivially copyable keys");
+
+  std::FILE *file;
+  const std::chrono::steady_clock::time_point started;
+  uint64_t last_timestamp;
+
+public:
+  explicit QueryTraceWriter(const std::string &path)
+      : file(std::fopen(path.c_str(), "wb")), started(std::chrono::steady_clock::now()), last_timestamp(0) {
+    if (file == nullptr) {
+      throw std::system_error(errno, std::generic_category(), "create " + path);
+    }
+
+    QueryTraceHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, QueryTraceHeader::expectedMagic(), sizeof(header.magic));
+    header.version = QueryTraceHeader::current_version;
+    header.key_size = sizeof(T);
+    header.key_kind = QueryTraceHeader::kindOf<T>();
+
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+      std::fclose(file);
+      throw std::system_error(errno, std::generic_category(), "write " + path);
+    }
+  }
+
+  QueryTraceWriter(const QueryTraceWriter &other) = delete;
+
+  QueryTraceWriter &operator=(const QueryTraceWriter &other) = delete;
+
+  ~QueryTraceWriter() { std::fclose(file); }
+
+  void record(QueryOp op, const T &key) {
+    const uint64_t timestamp =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+
+    unsigned char record[1 + 10 + sizeof(T)];
+    size_t length = 0;
+
+    record[length++] = static_cast<unsigned char>(op);
+
+    uint64_t delta = timestamp - last_timestamp;
+    do {
+      record[length++] = static_cast<unsigned char>((delta & 0x7f) | ((delta >= 0x80) ? 0x80 : 0));
+      delta >>= 7;
+    } while (delta != 0);
+
+    std::memcpy(record + length, &key, sizeof(T));
+    length += sizeof(T);
+
+    if (std::fwrite(record, 1, length, file) != length) {
+      throw std::system_error(errno, std::generic_category(), "write query trace");
+    }
+
+    last_timestamp = timestamp;
+  }
+
+  void flush() { std::fflush(file); }
+};
+
+inline QueryTraceHeader readQueryTraceHeader(std::FILE *file, const std::string &path) {
+  QueryTraceHeader header;
+
+  if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+      std::memcmp(header.magic, QueryTraceHeader::expectedMagic(), sizeof(header.magic)) != 0 ||
+      header.version != QueryTraceHeader::current_version) {
+    throw std::runtime_error(path + ": not a query trace");
+  }
+
+  return header;
+}
+
+inline QueryTraceHeader readQueryTraceHeader(const std::string &path) {
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    throw std::system_error(errno, std::generic_category(), "open " + path);
+  }
+
+  try {
+    const QueryTraceHeader header = readQueryTraceHeader(file, path);
+    std::fclose(file);
+    return header;
+  } catch (...) {
+    std::fclose(file);
+    throw;
+  }
+}
+
+template <class T> std::vector<QueryTraceRecord<T>> readQueryTrace(const std::string &path) {
+  static_assert(std::is_trivially_copyable<T>::value, "query traces require trivially copyable keys");
+
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    throw std::system_error(errno, std::generic_category(), "open " + path);
+  }
+
+  std::vector<QueryTraceRecord<T>> records;
+
+  try {
+    const QueryTraceHeader header = readQueryTraceHeader(file, path);
+
+    if (header.key_size != sizeof(T) || header.key_kind != QueryTraceHeader::kindOf<T>()) {
+      throw std::runtime_error(path + ": trace was recorded for a different key type");
+    }
+
+    uint64_t timestamp = 0;
+
+    for (int op; (op = std::getc(file)) != EOF;) {
+      if (op > static_cast<int>(QueryOp::Nearest)) {
+        throw std::runtime_error(path + ": corrupt query trace");
+      }
+
+      uint64_t delta = 0;
+      for (size_t shift = 0;; shift += 7) {
+        const int byte = std::getc(file);
+        if (byte == EOF || shift > 63) {
+          throw std::runtime_error(path + ": truncated query trace");
+        }
+        delta |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+          break;
+        }
+      }
+
+      QueryTraceRecord<T> record;
+      timestamp += delta;
+      record.timestamp = timestamp;
+      record.op = static_cast<QueryOp>(op);
+
+      if (std::fread(&record.key, sizeof(T), 1, file) != 1) {
+        throw std::runtime_error(path + ": truncated query trace");
+      }
+
+      records.push_back(record);
+    }
+  } catch (...) {
+    std::fclose(file);
+    throw;
+  }
+
+  std::fclose(file);
+  return records;
+}
+
+/* Write the contents of a set as a search tree file (see StaticSetBuilder), from which the replay tool rebuilds it. The
+ * file doesn't record the comparator, and the replay tool orders keys by std::less, so only such sets are accepted */
+template <class T, class Compare, class Allocator>
+void writeStaticSetSnapshot(const StaticSet<T, Compare, Allocator> &ss, const std::string &path) {
+  static_assert(std::is_same<Compare, std::less<T>>::value,
+                "snapshots can only be replayed for sets ordered by std::less");
+
+  StaticSetBuilder<T, Compare> builder(path, (ss.size() + 1) * sizeof(T), ss.valueComp());
+  builder.insert(ss.begin(), ss.end());
+  builder.finish();
+}
+
+/* Forwards queries to a StaticSet, logging each one to a trace. Sets that aren't being recorded pay nothing */
+template <class T, class Compare = std::less<T>, class Allocator = std::allocator<T>> class RecordedStaticSet {
+  typedef StaticSet<T, Compare, Allocator> Set;
+
+  const Set &ss;
+  QueryTraceWriter<T> &writer;
+
+public:
+  typedef typename Set::OrderedIterator OrderedIterator;
+
+  RecordedStaticSet(const Set &ss, QueryTraceWriter<T> &writer) : ss(ss), writer(writer) { ; }
+
+  const Set &set() const { return ss; }
+
+  bool contains(const T &needle) const {
+    writer.record(QueryOp::Contains, needle);
+    return ss.contains(needle);
+  }
+
+  OrderedIterator find(const T &needle) const {
+    writer.record(QueryOp::Find, needle);
+    return ss.find(needle);
+  }
+
+  OrderedIterator lower_bound(const T &needle) const {
+    writer.record(QueryOp::LowerBound, needle);
+    return ss.lower_bound(needle);
+  }
+
+  OrderedIterator lowerBound(const T &needle) const { return lower_bound(needle); }
+
+  OrderedIterator upper_bound(const T &needle) const {
+    writer.record(QueryOp::UpperBound, needle);
+    return ss.upper_bound(needle);
+  }
+
+  OrderedIterator upperBound(const T &needle) const { return upper_bound(needle); }
+
+  OrderedIterator predecessor(const T &needle) const {
+    writer.record(QueryOp::Predecessor, needle);
+    return ss.predecessor(needle);
+  }
+
+  OrderedIterator successor(const T &needle) const {
+    writer.record(QueryOp::Successor, needle);
+    return ss.successor(needle);
+  }
+
+  OrderedIterator floor(const T &needle) const {
+    writer.record(QueryOp::Floor, needle);
+    return ss.floor(needle);
+  }
+
+  OrderedIterator ceiling(const T &needle) const {
+    writer.record(QueryOp::Ceiling, needle);
+    return ss.ceiling(needle);
+  }
+
+  OrderedIterator nearest(const T &needle) const {
+    writer.record(QueryOp::Nearest, needle);
+    return ss.nearest(needle);
+  }
+};
+
+#endif
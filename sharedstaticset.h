@@ -0,0 +1,276 @@
+#ifndef LIBSTATICSET_SHAREDSTATICSET_H
+#define LIBSTATICSET_SHAREDSTATICSET_H
+
+#include "externalstaticset.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+
+/* Static sets in POSIX shared memory, built once by a publishing process and read in place by any number of worker
+ * processes on the same host, each of which maps the same physical pages.
+ *
+ * A set named "/name" consists of a small control segment, "/name" itself, and one tree segment per published
+ * generation, "/name.1", "/name.2" and so on. A tree segment has exactly the layout of a file written by
+ * StaticSetBuilder. The control segment records the current generation; publishing writes a complete new tree segment,
+ * then flips the generation with a single atomic store, then unlinks the previous segment. Workers that are still
+ * attached to an older generation keep their mapping, which the kernel frees once the last of them lets go */
+
+struct SharedStaticSetControl {
+  static const uint32_t current_version = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t element_size;
+
+  /* The generation of the current tree segment, or 0 if nothing has been published yet. The fields above are written
+   * before the first generation is published */
+  std::atomic<uint64_t> generation;
+
+  static const char *expectedMagic() { return "SSETSHM"; }
+
+  static std::string segmentName(const std::string &name, uint64_t generation) {
+    return name + "." + std::to_string(generation);
+  }
+
+  /* Map the control segment of the given set, read-only unless create is set, in which case it is created if need be */
+  static SharedStaticSetControl *attach(const std::string &name, bool create) {
+    const int fd = shm_open(name.c_str(), (create ? O_RDWR | O_CREAT : O_RDONLY), 0644);
+    if (fd == -1) {
+      throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+    }
+
+    /* A freshly created segment is empty; growing it zero-fills it, i.e. sets the generation to 0 */
+    struct stat status;
+    bool failed = (fstat(fd, &status) == -1);
+
+    if (!failed && create && status.st_size == 0) {
+      failed = (ftruncate(fd, sizeof(SharedStaticSetControl)) == -1);
+      status.st_size = sizeof(SharedStaticSetControl);
+    }
+
+    if (failed) {
+      const int error = errno;
+      close(fd);
+      throw std::system_error(error, std::generic_category(), "size " + name);
+    }
+
+    if (static_cast<size_t>(status.st_size) < sizeof(SharedStaticSetControl)) {
+      close(fd);
+      throw std::runtime_error(name + ": truncated control segment");
+    }
+
+    void *mapping =
+        mmap(nullptr, sizeof(SharedStaticSetControl), (create ? PROT_READ | PROT_WRITE : PROT_READ), MAP_SHARED, fd, 0);
+
+    const int error = errno;
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+      throw std::system_error(error, std::generic_category(), "mmap " + name);
+    }
+
+    SharedStaticSetControl *control = static_cast<SharedStaticSetControl *>(mapping);
+    assert(control->generation.is_lock_free());
+    return control;
+  }
+
+  static void detach(const SharedStaticSetControl *control) {
+    munmap(const_cast<SharedStaticSetControl *>(control), sizeof(SharedStaticSetControl));
+  }
+
+  bool valid(size_t expected_element_size) const {
+    return (std::memcmp(magic, expectedMagic(), sizeof(magic)) == 0 && version == current_version &&
+            element_size == expected_element_size);
+  }
+};
+
+/* A worker's read-only view of a shared set. Lookups never block or enter the kernel; refresh() moves the view to
+ * the most recently published generation, if it has changed. Iterators obtained before a refresh are invalidated by
+ * it. Each instance should be used by one thread at a time */
+template <class T, class Compare = std::less<T>> class SharedStaticSet : public StaticSetView<T, Compare> {
+  static_assert(std::is_trivially_copyable<T>::value, "SharedStaticSet requires trivially copyable elements");
+
+  const std::string name;
+  const SharedStaticSetControl *control;
+  uint64_t attached_generation;
+  std::unique_ptr<MappedStaticSet<T, Compare>> segment;
+
+public:
+  /* Attach to the set with the given name, which must have been created by a SharedStaticSetPublisher. The view is
+   * empty until something is published */
+  explicit SharedStaticSet(const std::string &name, const Compare &comp = Compare())
+      : StaticSetView<T, Compare>(comp), name(name),
+        control(SharedStaticSetControl::attach(name, false)), attached_generation(0) {
+    try {
+      refresh();
+    } catch (...) {
+      SharedStaticSetControl::detach(control);
+      throw;
+    }
+  }
+
+  SharedStaticSet(const SharedStaticSet &other) = delete;
+
+  SharedStaticSet &operator=(const SharedStaticSet &other) = delete;
+
+  ~SharedStaticSet() { SharedStaticSetControl::detach(control); }
+
+  /* The generation currently in view, or 0 if none */
+  uint64_t generation() const { return attached_generation; }
+
+  /* Switch to the latest published generation. Returns true if the view changed. A generation that is superseded
+   * and unlinked before we manage to attach to it is skipped; the next call picks up its successor */
+  bool refresh() {
+    const uint64_t latest = control->generation.load(std::memory_order_acquire);
+
+    if (latest == attached_generation) {
+      return false;
+    }
+
+    if (!control->valid(sizeof(T))) {
+      throw std::runtime_error(name + ": not a shared set of this element type");
+    }
+
+    const std::string segment_name = SharedStaticSetControl::segmentName(name, latest);
+    const int fd = shm_open(segment_name.c_str(), O_RDONLY, 0);
+
+    if (fd == -1) {
+      if (errno == ENOENT) {
+        return false;
+      }
+      throw std::system_error(errno, std::generic_category(), "shm_open " + segment_name);
+    }
+
+    segment.reset(new MappedStaticSet<T, Compare>(fd, segment_name, this->compare));
+
+    this->tree = segment->ubegin();
+    this->n = segment->size();
+    attached_generation = latest;
+
+    return true;
+  }
+};
+
+/* Builds and publishes generations of a shared set. There should be at most one publisher per set at a time. The set
+ * outlives the publisher; remove() deletes it */
+template <class T, class Compare = std::less<T>> class SharedStaticSetPublisher : private StaticSetTree {
+  static_assert(std::is_trivially_copyable<T>::value, "SharedStaticSetPublisher requires trivially copyable elements");
+
+  const std::string name;
+  const Compare compare;
+  SharedStaticSetControl *control;
+
+  /* Create the tree segment for the given generation from sorted, deduplicated values */
+  void writeSegment(const std::string &segment_name, const std::vector<T> &sorted) {
+    /* Left behind by a publisher that died between creating a segment and publishing it */
+    shm_unlink(segment_name.c_str());
+
+    const int fd = shm_open(segment_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1) {
+      throw std::system_error(errno, std::generic_category(), "shm_open " + segment_name);
+    }
+
+    const size_t n = sorted.size();
+    const size_t mapping_size = sizeof(StaticSetFileHeader) + n * sizeof(T);
+
+    void *mapping = MAP_FAILED;
+    if (ftruncate(fd, mapping_size) != -1) {
+      mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    const int error = errno;
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+      shm_unlink(segment_name.c_str());
+      throw std::system_error(error, std::generic_category(), "map " + segment_name);
+    }
+
+    StaticSetFileHeader *header = static_cast<StaticSetFileHeader *>(mapping);
+    std::memset(header, 0, sizeof(*header));
+    std::memcpy(header->magic, StaticSetFileHeader::expectedMagic(), sizeof(header->magic));
+    header->version = StaticSetFileHeader::current_version;
+    header->element_size = sizeof(T);
+    header->size = n;
+
+    /* Every node's position in the sorted sequence follows from its index, so the tree is written in one sequential
+     * pass straight into shared memory */
+    T *tree = reinterpret_cast<T *>(static_cast<char *>(mapping) + sizeof(StaticSetFileHeader));
+    for (size_t index = 0; index < n; index++) {
+      std::memcpy(tree + index, &sorted[rank(index, n)], sizeof(T));
+    }
+
+    munmap(mapping, mapping_size);
+  }
+
+public:
+  /* Create the set with the given name, or take over publishing an existing one */
+  explicit SharedStaticSetPublisher(const std::string &name, const Compare &comp = Compare())
+      : name(name), compare(comp), control(SharedStaticSetControl::attach(name, true)) {
+    if (control->generation.load() == 0) {
+      std::memcpy(control->magic, SharedStaticSetControl::expectedMagic(), sizeof(control->magic));
+      control->version = SharedStaticSetControl::current_version;
+      control->element_size = sizeof(T);
+    } else if (!control->valid(sizeof(T))) {
+      SharedStaticSetControl::detach(control);
+      throw std::runtime_error(name + ": not a shared set of this element type");
+    }
+  }
+
+  SharedStaticSetPublisher(const SharedStaticSetPublisher &other) = delete;
+
+  SharedStaticSetPublisher &operator=(const SharedStaticSetPublisher &other) = delete;
+
+  ~SharedStaticSetPublisher() { SharedStaticSetControl::detach(control); }
+
+  /* The most recently published generation, or 0 if none */
+  uint64_t generation() const { return control->generation.load(); }
+
+  template <class Iter> uint64_t publish(Iter first, Iter last) { return publish(std::vector<T>(first, last)); }
+
+  uint64_t publish(std::initializer_list<T> list) { return publish(std::vector<T>(list)); }
+
+  /* Build the given values into a new generation, make it current, and return its number */
+  uint64_t publish(std::vector<T> values) {
+    std::sort(values.begin(), values.end(), compare);
+    values.erase(std::unique(values.begin(), values.end(),
+                             [&](const T &x, const T &y) { return (!compare(x, y) && !compare(y, x)); }),
+                 values.end());
+
+    const uint64_t previous = control->generation.load();
+    const uint64_t next = previous + 1;
+
+    writeSegment(SharedStaticSetControl::segmentName(name, next), values);
+
+    control->generation.store(next, std::memory_order_release);
+
+    if (previous != 0) {
+      shm_unlink(SharedStaticSetControl::segmentName(name, previous).c_str());
+    }
+
+    return next;
+  }
+
+  /* Delete the named set. Processes still attached to it are unaffected, but no new workers can attach. Besides the
+   * current generation, this unlinks any neighbouring one left behind by a publisher that died mid-publish: the next
+   * generation, if it died before making it current, or the previous one, if it died before unlinking it */
+  static void remove(const std::string &name) {
+    try {
+      const SharedStaticSetControl *control = SharedStaticSetControl::attach(name, false);
+      const uint64_t generation = control->generation.load();
+      SharedStaticSetControl::detach(control);
+
+      for (uint64_t leftover = ((generation == 0) ? 1 : generation - 1); leftover <= generation + 1; leftover++) {
+        shm_unlink(SharedStaticSetControl::segmentName(name, leftover).c_str());
+      }
+    } catch (const std::exception &) {
+      /* Nothing to do beyond unlinking whatever is left of the control segment */
+    }
+
+    shm_unlink(name.c_str());
+  }
+};
+
+#endif
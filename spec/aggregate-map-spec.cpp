@@ -0,0 +1,130 @@
+#include "driver.h"
+#include "staticaggregatemap.h"
+
+#include <map>
+#include <random>
+#include <string>
+
+static std::default_random_engine generator;
+
+static std::vector<std::pair<int, long long>> generateRandomPairs(size_t count) {
+  std::uniform_int_distribution<int> keys(-(1 << 16), (1 << 16));
+  std::uniform_int_distribution<long long> values(-1000000, 1000000);
+
+  std::vector<std::pair<int, long long>> data;
+
+  while (count--) {
+    data.push_back(std::make_pair(keys(generator), values(generator)));
+  }
+
+  return data;
+}
+
+/* Aggregate the values of keys in [low, high) the slow way */
+template <class Aggregate>
+static typename Aggregate::Result aggregateNaively(const std::map<int, long long> &reference, int low, int high) {
+  typename Aggregate::Result result = Aggregate::identity();
+
+  if (low < high) {
+    for (auto it = reference.lower_bound(low); it != reference.lower_bound(high); ++it) {
+      result = Aggregate::combine(result, Aggregate::lift(it->second));
+    }
+  }
+
+  return result;
+}
+
+template <class Aggregate> static void checkAgainstNaiveAggregation(size_t size, StaticSetLayout layout) {
+  const std::vector<std::pair<int, long long>> data = generateRandomPairs(size);
+
+  /* The first occurrence of each key wins, as in std::map::insert */
+  const std::map<int, long long> reference(data.begin(), data.end());
+  const StaticAggregateMap<int, long long, Aggregate> map(data.begin(), data.end(), layout);
+
+  expect(map.size() == reference.size());
+  expect(map.aggregate() == aggregateNaively<Aggregate>(reference, INT_MIN, INT_MAX));
+
+  for (const auto &pair : reference) {
+    expect(map.at(pair.first) == pair.second);
+  }
+
+  std::uniform_int_distribution<int> distribution(-(1 << 17), (1 << 17));
+  std::uniform_int_distribution<int> widths(0, 1 << 10);
+
+  for (int k = 0; k < 1000; k++) {
+    const int low = distribution(generator);
+    const int high = ((k % 2 == 0) ? distribution(generator) : low + widths(generator));
+    expect(map.aggregate(low, high) == aggregateNaively<Aggregate>(reference, low, high));
+  }
+}
+
+describe("aggregate map", []() {
+  it("aggregates the values of all keys in a range, for invertible and idempotent operations alike", []() {
+    for (const StaticSetLayout layout : {StaticSetLayout::Tree, StaticSetLayout::Partitioned}) {
+      for (const size_t size : {0, 1, 5, 100, 10000}) {
+        checkAgainstNaiveAggregation<StaticSum<long long>>(size, layout);
+        checkAgainstNaiveAggregation<StaticCount<long long>>(size, layout);
+        checkAgainstNaiveAggregation<StaticMin<long long>>(size, layout);
+        checkAgainstNaiveAggregation<StaticMax<long long>>(size, layout);
+      }
+    }
+  });
+
+  it("looks up values by key, and by key iterator", []() {
+    const StaticAggregateMap<std::string, int> map = {{"b", 2}, {"a", 1}, {"c", 3}, {"a", 100}};
+
+    expect(map.size() == 3);
+    expect(map.at("a") == 1);
+    expect(map.contains("c") && !map.contains("d"));
+    expect(map.value(map.keySet().upperBound("a")) == 2);
+    expect(map.aggregate("a", "c") == 3);
+    expect(map.aggregate("b", "zzz") == 5);
+    expect(map.aggregate("c", "a") == 0);
+
+    bool thrown = false;
+    try {
+      map.at("d");
+    } catch (const std::out_of_range &) {
+      thrown = true;
+    }
+    expect(thrown);
+  });
+
+  it("leaves a moved-from map empty and usable", []() {
+    StaticAggregateMap<int, int> source = {{1, 10}, {2, 20}, {3, 30}};
+    StaticAggregateMap<int, int, StaticMin<int>> minimums = {{1, 10}, {2, 20}};
+
+    StaticAggregateMap<int, int> target(std::move(source));
+    expect(target.aggregate() == 60);
+    expect(source.empty() && source.size() == 0 && !source.contains(1));
+    expect(source.keySet().begin() == source.keySet().end());
+    expect(source.aggregate() == 0 && source.aggregate(0, 10) == 0);
+
+    StaticAggregateMap<int, int> assigned;
+    assigned = std::move(target);
+    expect(assigned.aggregate(2, 4) == 50);
+    expect(target.empty() && target.aggregate() == 0);
+
+    const StaticAggregateMap<int, int, StaticMin<int>> moved(std::move(minimums));
+    expect(moved.aggregate() == 10);
+    expect(minimums.empty() && minimums.aggregate() == std::numeric_limits<int>::max());
+  });
+
+  it("accepts a comparator, with or without a layout", []() {
+    typedef StaticAggregateMap<int, int, StaticSum<int>, std::greater<int>> Map;
+
+    const std::vector<std::pair<int, int>> pairs = {{1, 10}, {3, 30}, {2, 20}, {3, 300}};
+
+    const Map map(pairs.begin(), pairs.end(), std::greater<int>());
+    expect(std::vector<int>(map.keySet().begin(), map.keySet().end()) == std::vector<int>({3, 2, 1}));
+    expect(map.at(3) == 30);
+    expect(map.aggregate(3, 1) == 50);
+    expect(map.aggregate(1, 3) == 0);
+
+    const Map list({{1, 10}, {3, 30}, {2, 20}}, std::greater<int>());
+    expect(list.aggregate() == 60);
+
+    const Map moved(std::vector<std::pair<int, int>>(pairs), StaticSetLayout::Tree, std::greater<int>());
+    expect(moved.aggregate(2, 0) == 30);
+  });
+});
@@ -0,0 +1,106 @@
+#include "helpers.h"
+#include "staticbitmapset.h"
+
+#include <stdexcept>
+
+/* Each value of [low, low + range) is present with probability 1 / sparsity */
+template <class T> static std::vector<T> generateDenseVector(T low, size_t range, size_t sparsity) {
+  std::uniform_int_distribution<size_t> distribution(0, sparsity - 1);
+
+  std::vector<T> data;
+
+  for (size_t i = 0; i < range; i++) {
+    if (distribution(generator) == 0) {
+      data.push_back(static_cast<T>(low + static_cast<T>(i)));
+    }
+  }
+
+  return data;
+}
+
+/* Check the bitmap set against the sorted vector, and its ranks and neighbours against a StaticSet's */
+template <class T> static void checkBitmapSet(const std::vector<T> &data, T low, T high) {
+  const StaticBitmapSet<T> bs(data.begin(), data.end());
+  const StaticSet<T> ss(data.begin(), data.end());
+
+  checkAgainstSortedVector(bs, data, low, high);
+
+  for (int k = 0; k < 10000; k++) {
+    const T query = drawUniform(low, high);
+
+    expect(bs.rank(bs.lowerBound(query)) == ss.rank(ss.lowerBound(query)));
+    expect(bs.rank(bs.predecessor(query)) == ss.rank(ss.predecessor(query)));
+    expect(bs.rank(bs.successor(query)) == ss.rank(ss.successor(query)));
+    expect(bs.rank(bs.floor(query)) == ss.rank(ss.floor(query)));
+    expect(bs.rank(bs.ceiling(query)) == ss.rank(ss.ceiling(query)));
+    expect(bs.rank(bs.nearest(query)) == ss.rank(ss.nearest(query)));
+  }
+}
+
+describe("bitmap set", []() {
+  it("represents dense sets of integers compactly, and refuses sparse ones", []() {
+    std::vector<int> data;
+    for (int i = 0; i < 100000; i++) {
+      data.push_back(3 * i);
+    }
+
+    const StaticBitmapSet<int> dense(data.begin(), data.end());
+    expect(dense.size() == data.size());
+    expect(dense.memoryUsage() < data.size() * sizeof(int));
+
+    const StaticBitmapSet<int> empty;
+    expect(empty.empty() && empty.begin() == empty.end());
+    expect(empty.lowerBound(0) == empty.end() && empty.floor(0) == empty.end() && empty.nearest(0) == empty.end());
+
+    std::vector<int> sparse_data;
+    for (int i = 0; i < 1000; i++) {
+      sparse_data.push_back(129 * i);
+    }
+
+    bool threw = false;
+    try {
+      const StaticBitmapSet<int> sparse(sparse_data.begin(), sparse_data.end());
+    } catch (const std::invalid_argument &) {
+      threw = true;
+    }
+    expect(threw);
+  });
+
+  it("agrees with a sorted vector for membership, bounds, neighbours and iteration", []() {
+    for (const size_t sparsity : {1, 2, 16, 32}) {
+      for (const size_t range : {1, 63, 64, 65, 1000, 100000}) {
+        checkBitmapSet<int>(generateDenseVector<int>(-5000, range, sparsity), -6000, static_cast<int>(range));
+        checkBitmapSet<unsigned short>(generateDenseVector<unsigned short>(1000, range % 60000, sparsity), 0,
+                                       USHRT_MAX);
+      }
+
+      checkBitmapSet<long long>(generateDenseVector<long long>(LLONG_MAX - 100000, 100000, sparsity),
+                                LLONG_MAX - 200000, LLONG_MAX);
+    }
+  });
+
+  it("yields elements by value, so that references and reverse iteration are safe", []() {
+    const StaticBitmapSet<int> bs = {1, 2, 3, 64, 65, 200};
+
+    const int &found = *bs.find(64);
+    expect(found == 64);
+
+    typedef std::reverse_iterator<StaticBitmapSet<int>::OrderedIterator> Reverse;
+    expect(std::vector<int>(Reverse(bs.end()), Reverse(bs.begin())) == std::vector<int>({200, 65, 64, 3, 2, 1}));
+
+    auto it = bs.find(64);
+    expect(*++it == 65);
+    expect(*++it == 200);
+    expect(++it == bs.end());
+    expect(*--it == 200);
+    expect(bs.find(4) == bs.end());
+  });
+
+  it("leaves a moved-from set empty", []() {
+    StaticBitmapSet<int> source = {1, 2, 3};
+    const StaticBitmapSet<int> target(std::move(source));
+
+    expect(target.size() == 3);
+    expect(source.empty() && source.size() == 0 && source.begin() == source.end());
+  });
+});
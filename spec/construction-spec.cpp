@@ -0,0 +1,148 @@
+#include "driver.h"
+#include "staticset.h"
+
+#include <iterator>
+#include <memory>
+#include <random>
+
+static std::default_random_engine generator;
+
+/* Counts copies of itself, and has no default constructor */
+struct Counted {
+  static size_t copies;
+
+  int value;
+  std::vector<int> payload;
+
+  explicit Counted(int value) : value(value), payload(16, value) { ; }
+
+  Counted(const Counted &other) : value(other.value), payload(other.payload) { copies++; }
+
+  Counted(Counted &&other) = default;
+
+  Counted &operator=(const Counted &other) {
+    value = other.value;
+    payload = other.payload;
+    copies++;
+    return *this;
+  }
+
+  Counted &operator=(Counted &&other) = default;
+
+  bool operator<(const Counted &other) const { return (value < other.value); }
+};
+
+size_t Counted::copies = 0;
+
+/* Values drawn from a narrow range, so that the input is full of duplicates */
+static std::vector<Counted> generateCountedVector(size_t count) {
+  std::uniform_int_distribution<int> distribution(0, static_cast<int>(count / 2));
+
+  std::vector<Counted> data;
+
+  while (count--) {
+    data.emplace_back(distribution(generator));
+  }
+
+  return data;
+}
+
+static std::vector<int> sortedUniqueValues(const std::vector<Counted> &data) {
+  std::vector<int> values;
+  for (const auto &element : data) {
+    values.push_back(element.value);
+  }
+
+  std::sort(values.begin(), values.end());
+  values.resize(std::unique(values.begin(), values.end()) - values.begin());
+  return values;
+}
+
+template <class SS> static void checkContents(const SS &ss, const std::vector<int> &expected) {
+  std::vector<int> values;
+  for (const auto &element : ss) {
+    values.push_back(element.value);
+    expect(element.payload == std::vector<int>(16, element.value));
+  }
+  expect(values == expected);
+}
+
+describe("construction", []() {
+  it("never copies elements when given ownership of a vector", []() {
+    for (const size_t size : {0, 1, 5, 100, 10000}) {
+      std::vector<Counted> data = generateCountedVector(size);
+      const std::vector<int> expected = sortedUniqueValues(data);
+
+      Counted::copies = 0;
+      const StaticSet<Counted> ss(std::move(data));
+      expect(Counted::copies == 0);
+
+      checkContents(ss, expected);
+    }
+  });
+
+  it("never copies elements when given move iterators", []() {
+    std::vector<Counted> data = generateCountedVector(10000);
+    const std::vector<int> expected = sortedUniqueValues(data);
+
+    Counted::copies = 0;
+    const StaticSet<Counted> ss(std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+    expect(Counted::copies == 0);
+
+    checkContents(ss, expected);
+  });
+
+  it("copies each input element exactly once when given ordinary iterators", []() {
+    const std::vector<Counted> data = generateCountedVector(10000);
+
+    Counted::copies = 0;
+    const StaticSet<Counted> ss(data.begin(), data.end());
+    expect(Counted::copies == data.size());
+
+    checkContents(ss, sortedUniqueValues(data));
+  });
+
+  it("supports move-only elements", []() {
+    const auto compare = [](const std::unique_ptr<int> &x, const std::unique_ptr<int> &y) { return (*x < *y); };
+
+    std::vector<std::unique_ptr<int>> data;
+    for (int i = 0; i < 1000; i++) {
+      data.emplace_back(new int((i * 7919) % 500));
+    }
+
+    const StaticSet<std::unique_ptr<int>, decltype(compare)> ss(std::move(data), compare);
+    expect(ss.size() == 500);
+
+    int expected = 0;
+    for (const auto &pointer : ss) {
+      expect(*pointer == expected++);
+    }
+
+    expect(ss.contains(std::unique_ptr<int>(new int(250))));
+    expect(!ss.contains(std::unique_ptr<int>(new int(500))));
+    expect(**ss.upperBound(std::unique_ptr<int>(new int(41))) == 42);
+  });
+
+  it("leaves a moved-from set empty and usable", []() {
+    for (const StaticSetLayout layout : {StaticSetLayout::Tree, StaticSetLayout::Partitioned}) {
+      std::vector<int> data;
+      for (int i = 0; i < 10000; i++) {
+        data.push_back(3 * i);
+      }
+
+      StaticSet<int> source(data.begin(), data.end(), layout);
+      expect(source.layout() == layout);
+
+      StaticSet<int> target(std::move(source));
+      expect(target.size() == data.size());
+      expect(source.empty() && source.size() == 0);
+      expect(source.begin() == source.end());
+      expect(!source.contains(3) && source.lowerBound(3) == source.end());
+
+      StaticSet<int> assigned;
+      assigned = std::move(target);
+      expect(std::vector<int>(assigned.begin(), assigned.end()) == data);
+      expect(target.empty() && target.begin() == target.end());
+    }
+  });
+});
@@ -0,0 +1,145 @@
+#include "externalstaticset.h"
+#include "helpers.h"
+
+/* Values drawn from a narrow range, so that the input is full of duplicates */
+static std::vector<int> generateRandomVector(size_t count) {
+  std::uniform_int_distribution<int> distribution(-(1 << 16), (1 << 16));
+
+  std::vector<int> data;
+
+  while (count--) {
+    data.push_back(distribution(generator));
+  }
+
+  return data;
+}
+
+/* A trivially copyable element with no default constructor */
+struct Reading {
+  int value;
+
+  explicit Reading(int value) : value(value) { ; }
+
+  bool operator<(const Reading &other) const { return (value < other.value); }
+};
+
+describe("external construction", []() {
+  it("writes the same tree as StaticSet, for any memory budget", []() {
+    const std::vector<int> data = generateRandomVector(20000);
+    const StaticSet<int> ss(data.begin(), data.end(), StaticSetLayout::Tree);
+
+    for (const size_t budget : {size_t(1), 64 * sizeof(int), 1024 * sizeof(int), size_t(1) << 20}) {
+      const std::string path = temporaryPath();
+
+      StaticSetBuilder<int> builder(path, budget);
+      builder.insert(data.begin(), data.end());
+      builder.finish();
+
+      const MappedStaticSet<int> ms(path);
+      expect(std::vector<int>(ms.ubegin(), ms.uend()) == std::vector<int>(ss.ubegin(), ss.uend()));
+
+      std::remove(path.c_str());
+    }
+  });
+
+  it("supports lookups and ordered iteration through the mapped file", []() {
+    for (const size_t size : {0, 1, 5, 100, 100000}) {
+      const std::vector<int> data = generateRandomVector(size);
+      const std::string path = temporaryPath();
+
+      StaticSetBuilder<int> builder(path, 4096);
+      builder.insert(data.begin(), data.end());
+      builder.finish();
+
+      checkAgainstSortedVector(MappedStaticSet<int>(path), sortedUnique(data), -(1 << 17), 1 << 17);
+
+      std::remove(path.c_str());
+    }
+  });
+
+  it("consumes raw input files in chunks, merging in several passes if need be", []() {
+    const std::vector<int> data = generateRandomVector(200000);
+
+    const std::string input = temporaryPath();
+    std::FILE *file = std::fopen(input.c_str(), "wb");
+    std::fwrite(data.data(), sizeof(int), data.size(), file);
+    std::fclose(file);
+
+    const std::string path = temporaryPath();
+
+    size_t callbacks = 0;
+    StaticSetBuildProgress last;
+
+    StaticSetBuilder<int> builder(path, 256 * sizeof(int));
+    builder.onProgress([&](const StaticSetBuildProgress &progress) {
+      callbacks++;
+      last = progress;
+    });
+    builder.insertFile(input);
+
+    const StaticSetBuildProgress &stats = builder.finish();
+    expect(stats.phase == StaticSetBuildPhase::Done);
+    expect(stats.elements_read == data.size());
+    expect(stats.elements_written == sortedUnique(data).size());
+    expect(stats.runs_written > 63);
+    expect(stats.merge_passes == 2);
+    expect(stats.bytes_written > 0);
+    expect(callbacks > stats.runs_written && last.phase == StaticSetBuildPhase::Done);
+
+    checkAgainstSortedVector(MappedStaticSet<int>(path), sortedUnique(data), -(1 << 17), 1 << 17);
+
+    std::remove(input.c_str());
+    std::remove(path.c_str());
+  });
+
+  it("doesn't require elements to be default-constructible", []() {
+    const std::vector<int> data = generateRandomVector(20000);
+
+    std::vector<Reading> readings;
+    for (const int value : data) {
+      readings.push_back(Reading(value));
+    }
+
+    const std::string input = temporaryPath();
+    std::FILE *file = std::fopen(input.c_str(), "wb");
+    std::fwrite(readings.data(), sizeof(Reading), readings.size() / 2, file);
+    std::fclose(file);
+
+    const std::string path = temporaryPath();
+
+    StaticSetBuilder<Reading> builder(path, 256 * sizeof(Reading));
+    builder.insertFile(input);
+    builder.insert(readings.begin() + readings.size() / 2, readings.end());
+    expect(builder.finish().merge_passes == 2);
+
+    const MappedStaticSet<Reading> ms(path);
+
+    std::vector<int> values;
+    for (const Reading &reading : ms) {
+      values.push_back(reading.value);
+    }
+    expect(values == sortedUnique(data));
+    expect(ms.contains(Reading(data[0])) && ms.lowerBound(Reading(data[0]))->value == data[0]);
+
+    std::remove(input.c_str());
+    std::remove(path.c_str());
+  });
+
+  it("rejects files that weren't written for the given element type", []() {
+    const std::string path = temporaryPath();
+
+    StaticSetBuilder<int> builder(path, 4096);
+    builder.insert(1);
+    builder.finish();
+
+    bool rejected = false;
+    try {
+      MappedStaticSet<long long> ms(path);
+    } catch (const std::runtime_error &) {
+      rejected = true;
+    }
+    expect(rejected);
+
+    std::remove(path.c_str());
+  });
+});
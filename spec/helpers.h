@@ -0,0 +1,73 @@
+#ifndef LIBSTATICSET_SPEC_HELPERS_H
+#define LIBSTATICSET_SPEC_HELPERS_H
+
+#include "driver.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <unistd.h>
+
+static std::default_random_engine generator;
+
+/* uniform_int_distribution is undefined for types narrower than int, so those are drawn as int and narrowed */
+template <class T> static T drawUniform(T low, T high) {
+  typedef typename std::conditional<(sizeof(T) < sizeof(int)), int, T>::type Wide;
+  std::uniform_int_distribution<Wide> distribution(low, high);
+  return static_cast<T>(distribution(generator));
+}
+
+/* The name of a new, empty file, which the caller should remove */
+static inline std::string temporaryPath() {
+  char path[] = "/tmp/libstaticset-spec-XXXXXX";
+  const int fd = mkstemp(path);
+  close(fd);
+  return path;
+}
+
+template <class T> static std::vector<T> sortedUnique(std::vector<T> data) {
+  std::sort(data.begin(), data.end());
+  data.resize(std::unique(data.begin(), data.end()) - data.begin());
+  return data;
+}
+
+/* Check a set against the sorted, deduplicated vector of its elements: ordered iteration in both directions, then
+ * membership and bounds for queries drawn from [low, high] */
+template <class Set, class T>
+static void checkAgainstSortedVector(const Set &set, const std::vector<T> &sorted, T low, T high) {
+  expect(set.size() == sorted.size());
+  expect(std::vector<T>(set.begin(), set.end()) == sorted);
+
+  std::vector<T> backward;
+  for (auto it = set.end(); it != set.begin();) {
+    backward.push_back(*--it);
+  }
+  std::reverse(backward.begin(), backward.end());
+  expect(backward == sorted);
+
+  for (int k = 0; k < 10000; k++) {
+    const T query = drawUniform(low, high);
+
+    expect(set.contains(query) == std::binary_search(sorted.begin(), sorted.end(), query));
+
+    const auto lower = std::lower_bound(sorted.begin(), sorted.end(), query);
+    const auto set_lower = set.lowerBound(query);
+    expect((lower == sorted.end()) ? (set_lower == set.end()) : (*set_lower == *lower));
+
+    const auto upper = std::upper_bound(sorted.begin(), sorted.end(), query);
+    const auto set_upper = set.upperBound(query);
+    expect((upper == sorted.end()) ? (set_upper == set.end()) : (*set_upper == *upper));
+
+    if (set_lower != set.begin()) {
+      auto prev = set_lower;
+      --prev;
+      expect(*prev < query);
+    }
+  }
+}
+
+#endif
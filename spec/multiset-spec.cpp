@@ -0,0 +1,113 @@
+#include "driver.h"
+#include "staticmultiset.h"
+
+#include <random>
+#include <set>
+#include <string>
+
+static std::default_random_engine generator;
+
+/* Values drawn from a narrow range, so that the input is full of duplicates */
+static std::vector<int> generateRandomVector(size_t count, int range) {
+  std::uniform_int_distribution<int> distribution(-range, range);
+
+  std::vector<int> data;
+
+  while (count--) {
+    data.push_back(distribution(generator));
+  }
+
+  return data;
+}
+
+describe("multiset", []() {
+  it("iterates each element as many times as it occurs, in order, in both directions", []() {
+    for (const StaticSetLayout layout : {StaticSetLayout::Tree, StaticSetLayout::Partitioned}) {
+      for (const size_t size : {0, 1, 5, 100, 100000}) {
+        std::vector<int> data = generateRandomVector(size, 1 << 12);
+        const StaticMultiSet<int> ms(data.begin(), data.end(), layout);
+
+        std::sort(data.begin(), data.end());
+        expect(ms.size() == data.size());
+        expect(std::vector<int>(ms.begin(), ms.end()) == data);
+
+        std::vector<int> backward;
+        for (auto it = ms.end(); it != ms.begin();) {
+          backward.push_back(*--it);
+        }
+        std::reverse(backward.begin(), backward.end());
+        expect(backward == data);
+      }
+    }
+  });
+
+  it("counts occurrences of individual elements, and of ranges of elements", []() {
+    for (const StaticSetLayout layout : {StaticSetLayout::Tree, StaticSetLayout::Partitioned}) {
+      const std::vector<int> data = generateRandomVector(100000, 1 << 12);
+      const std::multiset<int> reference(data.begin(), data.end());
+      const StaticMultiSet<int> ms(data.begin(), data.end(), layout);
+
+      expect(ms.distinctSize() == std::set<int>(data.begin(), data.end()).size());
+
+      std::uniform_int_distribution<int> distribution(-(1 << 13), (1 << 13));
+
+      for (int k = 0; k < 10000; k++) {
+        const int x = distribution(generator);
+        expect(ms.count(x) == reference.count(x));
+        expect(ms.contains(x) == (reference.count(x) != 0));
+
+        const int y = distribution(generator);
+        const size_t in_range =
+            ((x < y) ? std::distance(reference.lower_bound(x), reference.lower_bound(y)) : 0);
+        expect(ms.count(x, y) == in_range);
+      }
+    }
+  });
+
+  it("exposes equal_range, spanning every copy of an element", []() {
+    const StaticMultiSet<std::string> ms = {"b", "a", "c", "b", "b", "d", "a"};
+
+    const auto range = ms.equalRange("b");
+    expect(std::vector<std::string>(range.first, range.second) == std::vector<std::string>({"b", "b", "b"}));
+    expect(*range.second == "c");
+
+    const auto missing = ms.equal_range("bb");
+    expect(missing.first == missing.second && *missing.first == "c");
+
+    expect(ms.find("a") == ms.begin());
+    expect(ms.find("e") == ms.end());
+    expect(ms.count("a", "c") == 5);
+    expect(ms.count("c", "a") == 0);
+  });
+
+  it("accepts a comparator, with or without a layout", []() {
+    const std::vector<int> data = {3, 1, 3, 2, 1, 3};
+    const std::vector<int> descending = {3, 3, 3, 2, 1, 1};
+
+    const StaticMultiSet<int, std::greater<int>> ms(data.begin(), data.end(), std::greater<int>());
+    expect(std::vector<int>(ms.begin(), ms.end()) == descending);
+    expect(ms.count(3) == 3 && ms.count(3, 1) == 4);
+
+    const StaticMultiSet<int, std::greater<int>> list({3, 1, 3, 2, 1, 3}, std::greater<int>());
+    expect(std::vector<int>(list.begin(), list.end()) == descending);
+
+    const StaticMultiSet<int, std::greater<int>> moved(std::vector<int>(data), StaticSetLayout::Tree,
+                                                       std::greater<int>());
+    expect(std::vector<int>(moved.begin(), moved.end()) == descending);
+  });
+
+  it("leaves a moved-from multiset empty and usable", []() {
+    StaticMultiSet<int> source = {1, 1, 2, 3, 3, 3};
+
+    StaticMultiSet<int> target(std::move(source));
+    expect(target.size() == 6 && target.count(3) == 3);
+    expect(source.empty() && source.size() == 0 && source.distinctSize() == 0);
+    expect(source.begin() == source.end());
+    expect(source.count(1) == 0 && source.count(0, 10) == 0);
+
+    StaticMultiSet<int> assigned;
+    assigned = std::move(target);
+    expect(std::vector<int>(assigned.begin(), assigned.end()) == std::vector<int>({1, 1, 2, 3, 3, 3}));
+    expect(target.empty() && target.begin() == target.end());
+  });
+});
@@ -0,0 +1,172 @@
+#include "helpers.h"
+#include "staticset.h"
+
+#include <climits>
+#include <iterator>
+#include <string>
+
+/* Values clustered around a few centres, so that some partitions are empty and others crowded */
+static std::vector<int> generateClusteredVector(size_t count, int spread) {
+  std::uniform_int_distribution<int> centres(-8, 8);
+  std::uniform_int_distribution<int> offsets(-spread, spread);
+
+  std::vector<int> data;
+
+  while (count--) {
+    data.push_back(centres(generator) * spread * 16 + offsets(generator));
+  }
+
+  return data;
+}
+
+/* Reference answers, as positions in the sorted vector (sorted.size() if there is none) */
+
+static size_t referencePredecessor(const std::vector<int> &sorted, int needle) {
+  const size_t ceiling = std::lower_bound(sorted.begin(), sorted.end(), needle) - sorted.begin();
+  return ((ceiling == 0) ? sorted.size() : ceiling - 1);
+}
+
+static size_t referenceFloor(const std::vector<int> &sorted, int needle) {
+  const size_t successor = std::upper_bound(sorted.begin(), sorted.end(), needle) - sorted.begin();
+  return ((successor == 0) ? sorted.size() : successor - 1);
+}
+
+static size_t referenceNearest(const std::vector<int> &sorted, int needle) {
+  const size_t floor = referenceFloor(sorted, needle);
+  const size_t ceiling = std::lower_bound(sorted.begin(), sorted.end(), needle) - sorted.begin();
+
+  if (floor == sorted.size() || ceiling == sorted.size()) {
+    return std::min(floor, ceiling);
+  }
+
+  return ((int64_t(sorted[ceiling]) - needle < int64_t(needle) - sorted[floor]) ? ceiling : floor);
+}
+
+static void checkNeighbours(const std::vector<int> &data, StaticSetLayout layout) {
+  const std::vector<int> sorted = sortedUnique(data);
+  const StaticSet<int> ss(data.begin(), data.end(), layout);
+  expect(ss.layout() == layout);
+
+  const int low = sorted.front() - 100;
+  const int high = sorted.back() + 100;
+
+  checkAgainstSortedVector(ss, sorted, low, high);
+
+  std::vector<int> needles;
+  for (int needle = low; needle <= high; needle += std::max(1, (high - low) / 20000)) {
+    needles.push_back(needle);
+  }
+
+  for (const int needle : needles) {
+    expect(ss.rank(ss.predecessor(needle)) == referencePredecessor(sorted, needle));
+    expect(ss.rank(ss.floor(needle)) == referenceFloor(sorted, needle));
+    expect(ss.ceiling(needle) == ss.lower_bound(needle));
+    expect(ss.successor(needle) == ss.upper_bound(needle));
+    expect(ss.rank(ss.nearest(needle)) == referenceNearest(sorted, needle));
+  }
+
+  /* Batch sizes that aren't a multiple of the lockstep group */
+  while (needles.size() % 16 != 7) {
+    needles.pop_back();
+  }
+
+  std::vector<size_t> ranks;
+
+  ss.predecessorRanks(needles.begin(), needles.end(), std::back_inserter(ranks));
+  ss.successorRanks(needles.begin(), needles.end(), std::back_inserter(ranks));
+  ss.floorRanks(needles.begin(), needles.end(), std::back_inserter(ranks));
+  ss.ceilingRanks(needles.begin(), needles.end(), std::back_inserter(ranks));
+  ss.nearestRanks(needles.begin(), needles.end(), std::back_inserter(ranks));
+
+  expect(ranks.size() == 5 * needles.size());
+
+  const size_t *batch = ranks.data();
+  for (const int needle : needles) {
+    const size_t n = needles.size();
+    expect(batch[0] == ss.rank(ss.predecessor(needle)));
+    expect(batch[n] == ss.rank(ss.successor(needle)));
+    expect(batch[2 * n] == ss.rank(ss.floor(needle)));
+    expect(batch[3 * n] == ss.rank(ss.ceiling(needle)));
+    expect(batch[4 * n] == ss.rank(ss.nearest(needle)));
+    batch++;
+  }
+}
+
+describe("neighbours", []() {
+  it("agree with a sorted vector for every layout", []() {
+    checkNeighbours(generateClusteredVector(1000, 1000), StaticSetLayout::Tree);
+    checkNeighbours(generateClusteredVector(20000, 100000), StaticSetLayout::Partitioned);
+  });
+
+  it("return end() where there is no such element", []() {
+    const StaticSet<int> empty;
+    expect(empty.floor(0) == empty.end());
+    expect(empty.nearest(0) == empty.end());
+
+    std::vector<size_t> ranks;
+    const std::vector<int> needles = {1, 2, 3};
+    empty.ceilingRanks(needles.begin(), needles.end(), std::back_inserter(ranks));
+    expect(ranks == std::vector<size_t>(3, 0));
+
+    const StaticSet<int> ss = {10, 20, 30};
+    expect(ss.predecessor(10) == ss.end());
+    expect(*ss.floor(10) == 10);
+    expect(ss.successor(30) == ss.end());
+    expect(*ss.ceiling(30) == 30);
+    expect(*ss.nearest(-1000) == 10);
+    expect(*ss.nearest(1000) == 30);
+  });
+
+  it("prefer the smaller element when two are equally near", []() {
+    const StaticSet<int> ss = {10, 20, 30};
+    expect(*ss.nearest(15) == 10);
+    expect(*ss.nearest(16) == 20);
+    expect(*ss.nearest(25) == 20);
+    expect(*ss.nearest(20) == 20);
+
+    const StaticSet<double> ds = {1.0, 2.0};
+    expect(*ds.nearest(1.5) == 1.0);
+    expect(*ds.nearest(1.75) == 2.0);
+  });
+
+  it("measure distance without overflowing at the extremes of the key type", []() {
+    const StaticSet<int> ss = {INT_MIN, INT_MAX};
+    expect(*ss.nearest(-1) == INT_MIN);
+    expect(*ss.nearest(0) == INT_MAX);
+
+    const StaticSet<int> balanced = {INT_MIN + 1, INT_MAX};
+    expect(*balanced.nearest(0) == INT_MIN + 1);
+  });
+
+  it("respect the given comparator", []() {
+    const StaticSet<int, std::greater<int>> ss({10, 20, 30});
+    expect(*ss.predecessor(20) == 30);
+    expect(*ss.successor(20) == 10);
+    expect(*ss.floor(25) == 30);
+    expect(*ss.ceiling(25) == 20);
+
+    const StaticSet<int, std::greater<int>> spread({0, 10, 100});
+    expect(*spread.nearest(9) == 10);
+    expect(*spread.nearest(90) == 100);
+    expect(*spread.nearest(5) == 10);
+
+    const StaticSet<long long, std::greater<long long>> extremes({LLONG_MIN, 0, LLONG_MAX});
+    expect(*extremes.nearest(LLONG_MIN + 1) == LLONG_MIN);
+    expect(*extremes.nearest(LLONG_MAX - 1) == LLONG_MAX);
+    expect(*extremes.nearest(-1) == 0);
+  });
+
+  it("need no arithmetic on the element type, except for nearest", []() {
+    const StaticSet<std::string> ss({"apple", "cherry", "plum"});
+    expect(*ss.predecessor("cherry") == "apple");
+    expect(*ss.successor("cherry") == "plum");
+    expect(*ss.floor("banana") == "apple");
+    expect(*ss.ceiling("banana") == "cherry");
+    expect(ss.floor("aardvark") == ss.end());
+
+    const std::vector<std::string> needles = {"banana", "zebra"};
+    std::vector<size_t> ranks;
+    ss.floorRanks(needles.begin(), needles.end(), std::back_inserter(ranks));
+    expect(ranks == std::vector<size_t>({0, 2}));
+  });
+});
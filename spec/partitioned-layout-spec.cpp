@@ -0,0 +1,87 @@
+#include "helpers.h"
+#include "staticset.h"
+
+#include <climits>
+#include <string>
+
+/* Clusters of consecutive values separated by wide gaps, so that most partitions of the top-level table are empty */
+template <class T> static std::vector<T> generateClusteredVector(size_t count, T low, T high) {
+  std::vector<T> data;
+
+  while (data.size() < count) {
+    const T start = drawUniform(low, high);
+    for (int i = 0; i < 100 && start + i <= high; i++) {
+      data.push_back(start + i);
+    }
+  }
+
+  std::sort(data.begin(), data.end());
+  data.resize(std::unique(data.begin(), data.end()) - data.begin());
+
+  return data;
+}
+
+template <class T> static void checkPartitioned(const std::vector<T> &data, T low, T high) {
+  const StaticSet<T> ss(data.begin(), data.end(), StaticSetLayout::Partitioned);
+  expect(ss.layout() == StaticSetLayout::Partitioned);
+
+  checkAgainstSortedVector(ss, data, low, high);
+}
+
+describe("partitioned layout", []() {
+  it("is chosen automatically for large sets of integers ordered by std::less", []() {
+    std::vector<int> data;
+    for (int i = 0; i < 100000; i++) {
+      data.push_back(1000 * i);
+    }
+
+    const StaticSet<int> large(data.begin(), data.end());
+    expect(large.layout() == StaticSetLayout::Partitioned);
+
+    const StaticSet<int> small(data.begin(), data.begin() + 100);
+    expect(small.layout() == StaticSetLayout::Tree);
+
+    const StaticSet<int, std::greater<int>> reversed(data.begin(), data.end(), StaticSetLayout::Partitioned);
+    expect(reversed.layout() == StaticSetLayout::Tree);
+
+    const StaticSet<int> tree(data.begin(), data.end(), StaticSetLayout::Tree);
+    expect(tree.layout() == StaticSetLayout::Tree);
+
+    const std::vector<std::string> strings = {"a", "b", "c"};
+    const StaticSet<std::string> unsuitable(strings.begin(), strings.end(), StaticSetLayout::Partitioned);
+    expect(unsuitable.layout() == StaticSetLayout::Tree);
+  });
+
+  it("agrees with a sorted vector for bounds and ordered iteration across partition boundaries", []() {
+    for (const size_t size : {100, 1000, 100000}) {
+      checkPartitioned(generateClusteredVector<int>(size, -(1 << 24), (1 << 24)), -(1 << 25), (1 << 25));
+      checkPartitioned(generateClusteredVector<unsigned>(size, 0, UINT_MAX - 200), 0U, UINT_MAX);
+      checkPartitioned(generateClusteredVector<long long>(size, LLONG_MIN / 2, LLONG_MAX / 2), LLONG_MIN, LLONG_MAX);
+      checkPartitioned<short>(generateClusteredVector<short>(size / 100 + 2, -30000, 30000), SHRT_MIN, SHRT_MAX);
+    }
+  });
+
+  it("handles the extremes of the key type", []() {
+    /* Runs at both ends of the key range and around zero, enough of them for the set to be partitioned */
+    std::vector<int> data;
+    for (int i = 0; i < 2000; i++) {
+      data.push_back(INT_MIN + i);
+      data.push_back(i - 1000);
+      data.push_back(INT_MAX - i);
+    }
+    std::sort(data.begin(), data.end());
+
+    const StaticSet<int> ss(data.begin(), data.end(), StaticSetLayout::Partitioned);
+    expect(ss.layout() == StaticSetLayout::Partitioned);
+
+    expect(std::vector<int>(ss.begin(), ss.end()) == data);
+    expect(*ss.begin() == INT_MIN);
+    expect(*--ss.end() == INT_MAX);
+    expect(*ss.lowerBound(INT_MIN) == INT_MIN);
+    expect(*ss.upperBound(INT_MIN + 1999) == -1000);
+    expect(*ss.upperBound(999) == INT_MAX - 1999);
+    expect(ss.upperBound(INT_MAX) == ss.end());
+    expect(ss.contains(INT_MIN) && ss.contains(INT_MAX) && ss.contains(-1));
+    expect(!ss.contains(INT_MIN + 2000) && !ss.contains(1000) && !ss.contains(INT_MAX - 2000));
+  });
+});
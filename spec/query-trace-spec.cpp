@@ -0,0 +1,161 @@
+#include "helpers.h"
+#include "querytrace.h"
+
+static std::vector<int64_t> generateRandomVector(size_t count) {
+  std::uniform_int_distribution<int64_t> distribution(-(1LL << 40), (1LL << 40));
+
+  std::vector<int64_t> data;
+
+  while (count--) {
+    data.push_back(distribution(generator));
+  }
+
+  return data;
+}
+
+describe("query traces", []() {
+  it("forwards queries to the recorded set unchanged", []() {
+    const std::string path = temporaryPath();
+    const StaticSet<int64_t> ss(generateRandomVector(10000));
+
+    {
+      QueryTraceWriter<int64_t> writer(path);
+      const RecordedStaticSet<int64_t> recorded(ss, writer);
+
+      for (const int64_t needle : generateRandomVector(1000)) {
+        expect(recorded.contains(needle) == ss.contains(needle));
+        expect(recorded.find(needle) == ss.find(needle));
+        expect(recorded.lowerBound(needle) == ss.lowerBound(needle));
+        expect(recorded.upperBound(needle) == ss.upperBound(needle));
+        expect(recorded.floor(needle) == ss.floor(needle));
+        expect(recorded.nearest(needle) == ss.nearest(needle));
+      }
+    }
+
+    std::remove(path.c_str());
+  });
+
+  it("reads back every recorded query, in order", []() {
+    const std::string path = temporaryPath();
+    const StaticSet<int64_t> ss(generateRandomVector(1000));
+
+    const std::vector<int64_t> needles = generateRandomVector(5000);
+    const QueryOp ops[] = {QueryOp::Contains,   QueryOp::Find,        QueryOp::LowerBound,
+                           QueryOp::UpperBound, QueryOp::Predecessor, QueryOp::Successor,
+                           QueryOp::Floor,      QueryOp::Ceiling,     QueryOp::Nearest};
+    const size_t op_count = sizeof(ops) / sizeof(ops[0]);
+
+    {
+      QueryTraceWriter<int64_t> writer(path);
+      const RecordedStaticSet<int64_t> recorded(ss, writer);
+
+      for (size_t i = 0; i < needles.size(); i++) {
+        switch (ops[i % op_count]) {
+        case QueryOp::Contains:
+          recorded.contains(needles[i]);
+          break;
+        case QueryOp::Find:
+          recorded.find(needles[i]);
+          break;
+        case QueryOp::LowerBound:
+          recorded.lower_bound(needles[i]);
+          break;
+        case QueryOp::UpperBound:
+          recorded.upper_bound(needles[i]);
+          break;
+        case QueryOp::Predecessor:
+          recorded.predecessor(needles[i]);
+          break;
+        case QueryOp::Successor:
+          recorded.successor(needles[i]);
+          break;
+        case QueryOp::Floor:
+          recorded.floor(needles[i]);
+          break;
+        case QueryOp::Ceiling:
+          recorded.ceiling(needles[i]);
+          break;
+        case QueryOp::Nearest:
+          recorded.nearest(needles[i]);
+          break;
+        }
+      }
+    }
+
+    const std::vector<QueryTraceRecord<int64_t>> records = readQueryTrace<int64_t>(path);
+    expect(records.size() == needles.size());
+
+    for (size_t i = 0; i < records.size(); i++) {
+      expect(records[i].key == needles[i]);
+      expect(records[i].op == ops[i % op_count]);
+      expect(i == 0 || records[i - 1].timestamp <= records[i].timestamp);
+    }
+
+    std::remove(path.c_str());
+  });
+
+  it("records the key type in the header, and refuses to read a trace as another type", []() {
+    const std::string path = temporaryPath();
+
+    {
+      QueryTraceWriter<uint32_t> writer(path);
+      writer.record(QueryOp::Find, 42);
+    }
+
+    const QueryTraceHeader header = readQueryTraceHeader(path);
+    expect(header.key_size == sizeof(uint32_t));
+    expect(header.key_kind == QueryTraceKeyKind::Unsigned);
+
+    expect(readQueryTrace<uint32_t>(path).size() == 1);
+
+    bool threw = false;
+    try {
+      readQueryTrace<int32_t>(path);
+    } catch (const std::runtime_error &) {
+      threw = true;
+    }
+    expect(threw);
+
+    std::remove(path.c_str());
+  });
+
+  it("rejects records with an unknown operation", []() {
+    const std::string path = temporaryPath();
+
+    {
+      QueryTraceWriter<uint32_t> writer(path);
+      writer.record(QueryOp::Nearest, 42);
+    }
+
+    expect(readQueryTrace<uint32_t>(path).size() == 1);
+
+    std::FILE *file = std::fopen(path.c_str(), "r+b");
+    std::fseek(file, sizeof(QueryTraceHeader), SEEK_SET);
+    std::fputc(static_cast<int>(QueryOp::Nearest) + 1, file);
+    std::fclose(file);
+
+    bool threw = false;
+    try {
+      readQueryTrace<uint32_t>(path);
+    } catch (const std::runtime_error &) {
+      threw = true;
+    }
+    expect(threw);
+
+    std::remove(path.c_str());
+  });
+
+  it("snapshots a set into a file from which it can be rebuilt", []() {
+    const std::string path = temporaryPath();
+
+    for (const size_t size : {0, 1, 7, 10000}) {
+      const StaticSet<int64_t> ss(generateRandomVector(size));
+      writeStaticSetSnapshot(ss, path);
+
+      const MappedStaticSet<int64_t> mapped(path);
+      expect(std::vector<int64_t>(mapped.begin(), mapped.end()) == std::vector<int64_t>(ss.begin(), ss.end()));
+    }
+
+    std::remove(path.c_str());
+  });
+});
@@ -268,6 +268,23 @@ describe("search", []() {
     });
   });
 
+  describe("rank", []() {
+    it("returns the position of an element in the ordered sequence, or size() for end()", []() {
+      for (const StaticSetLayout layout : {StaticSetLayout::Tree, StaticSetLayout::Partitioned}) {
+        for (const size_t size : {0, 1, 5, 100, 1000, 100000}) {
+          const std::vector<int> data = generateRandomVector(size);
+          const StaticSet<int> ss(data.begin(), data.end(), layout);
+
+          size_t expected = 0;
+          for (auto it = ss.begin(); it != ss.end(); ++it) {
+            expect(ss.rank(it) == expected++);
+          }
+          expect(ss.rank(ss.end()) == ss.size());
+        }
+      }
+    });
+  });
+
   describe("contains", []() {
     it("returns a boolean indicating the presence/absence of an element that compares equal to the query", []() {
       std::vector<int> data;
@@ -0,0 +1,170 @@
+#include "driver.h"
+#include "sharedstaticset.h"
+
+#include <random>
+
+#include <sys/wait.h>
+
+static std::default_random_engine generator;
+
+static std::string uniqueName() {
+  static size_t counter = 0;
+  return "/libstaticset-spec-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+}
+
+static std::vector<int> generateRandomVector(size_t count) {
+  std::uniform_int_distribution<int> distribution(-(1 << 20), (1 << 20));
+
+  std::vector<int> data;
+
+  while (count--) {
+    data.push_back(distribution(generator));
+  }
+
+  return data;
+}
+
+static bool segmentExists(const std::string &name) {
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd == -1) {
+    return false;
+  }
+  close(fd);
+  return true;
+}
+
+template <class View> static bool sameContents(const View &view, const StaticSet<int> &ss) {
+  return (view.size() == ss.size() &&
+          std::vector<int>(view.begin(), view.end()) == std::vector<int>(ss.begin(), ss.end()));
+}
+
+describe("shared static set", []() {
+  it("lets workers read what the publisher published", []() {
+    const std::string name = uniqueName();
+    const std::vector<int> data = generateRandomVector(10000);
+
+    SharedStaticSetPublisher<int> publisher(name);
+    expect(publisher.generation() == 0);
+    expect(publisher.publish(data.begin(), data.end()) == 1);
+
+    const SharedStaticSet<int> worker(name);
+    const StaticSet<int> ss(data.begin(), data.end());
+
+    expect(worker.generation() == 1);
+    expect(sameContents(worker, ss));
+
+    for (const int needle : generateRandomVector(1000)) {
+      expect(worker.contains(needle) == ss.contains(needle));
+    }
+
+    SharedStaticSetPublisher<int>::remove(name);
+  });
+
+  it("picks up new generations on refresh, and not before", []() {
+    const std::string name = uniqueName();
+
+    SharedStaticSetPublisher<int> publisher(name);
+    SharedStaticSet<int> worker(name);
+
+    expect(worker.generation() == 0);
+    expect(worker.empty());
+    expect(!worker.refresh());
+
+    publisher.publish({1, 2, 3});
+    expect(worker.empty());
+    expect(worker.refresh());
+    expect(sameContents(worker, StaticSet<int>({1, 2, 3})));
+    expect(!worker.refresh());
+
+    publisher.publish({4, 5});
+    expect(sameContents(worker, StaticSet<int>({1, 2, 3})));
+    expect(worker.refresh());
+    expect(worker.generation() == 2);
+    expect(sameContents(worker, StaticSet<int>({4, 5})));
+
+    SharedStaticSetPublisher<int>::remove(name);
+  });
+
+  it("unlinks superseded generations, while workers attached to them keep reading", []() {
+    const std::string name = uniqueName();
+
+    SharedStaticSetPublisher<int> publisher(name);
+    publisher.publish({1, 2, 3});
+
+    const SharedStaticSet<int> stale(name);
+
+    publisher.publish({4, 5, 6});
+    publisher.publish({7, 8, 9});
+
+    expect(!segmentExists(SharedStaticSetControl::segmentName(name, 1)));
+    expect(!segmentExists(SharedStaticSetControl::segmentName(name, 2)));
+    expect(segmentExists(SharedStaticSetControl::segmentName(name, 3)));
+
+    expect(sameContents(stale, StaticSet<int>({1, 2, 3})));
+    expect(sameContents(SharedStaticSet<int>(name), StaticSet<int>({7, 8, 9})));
+
+    SharedStaticSetPublisher<int>::remove(name);
+    expect(!segmentExists(name));
+    expect(!segmentExists(SharedStaticSetControl::segmentName(name, 3)));
+  });
+
+  it("removes generations left behind by a publisher that died mid-publish", []() {
+    const std::string name = uniqueName();
+
+    SharedStaticSetPublisher<int> publisher(name);
+    publisher.publish({1, 2, 3});
+    publisher.publish({4, 5, 6});
+
+    /* As if a publisher had died before unlinking generation 1, and another before making generation 3 current */
+    for (const uint64_t generation : {1, 3}) {
+      const std::string segment = SharedStaticSetControl::segmentName(name, generation);
+      close(shm_open(segment.c_str(), O_RDWR | O_CREAT, 0644));
+      expect(segmentExists(segment));
+    }
+
+    SharedStaticSetPublisher<int>::remove(name);
+    expect(!segmentExists(name));
+
+    for (const uint64_t generation : {1, 2, 3}) {
+      expect(!segmentExists(SharedStaticSetControl::segmentName(name, generation)));
+    }
+  });
+
+  it("is shared between processes", []() {
+    const std::string name = uniqueName();
+    const std::vector<int> data = generateRandomVector(10000);
+
+    SharedStaticSetPublisher<int> publisher(name);
+    publisher.publish(data.begin(), data.end());
+
+    const pid_t child = fork();
+
+    if (child == 0) {
+      const SharedStaticSet<int> worker(name);
+      _exit(sameContents(worker, StaticSet<int>(data.begin(), data.end())) ? 0 : 1);
+    }
+
+    int status = -1;
+    waitpid(child, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    SharedStaticSetPublisher<int>::remove(name);
+  });
+
+  it("refuses to attach to a set of another element type", []() {
+    const std::string name = uniqueName();
+
+    SharedStaticSetPublisher<int> publisher(name);
+    publisher.publish({1, 2, 3});
+
+    bool threw = false;
+    try {
+      const SharedStaticSet<int64_t> worker(name);
+    } catch (const std::runtime_error &) {
+      threw = true;
+    }
+    expect(threw);
+
+    SharedStaticSetPublisher<int>::remove(name);
+  });
+});
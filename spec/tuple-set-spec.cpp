@@ -0,0 +1,130 @@
+#include "driver.h"
+#include "statictupleset.h"
+
+#include <random>
+#include <set>
+#include <string>
+
+static std::default_random_engine generator;
+
+typedef std::tuple<uint32_t, uint32_t, uint64_t> Key;
+
+/* Narrow ranges in the leading columns, so that prefixes are shared by many tuples */
+static std::vector<Key> generateRandomKeys(size_t count) {
+  std::uniform_int_distribution<uint32_t> first(0, 100);
+  std::uniform_int_distribution<uint32_t> second(0, 10);
+  std::uniform_int_distribution<uint64_t> third(0, UINT64_MAX);
+
+  std::vector<Key> data;
+
+  while (count--) {
+    data.push_back(Key(first(generator), second(generator), third(generator)));
+  }
+
+  return data;
+}
+
+describe("tuple set", []() {
+  it("iterates its tuples in lexicographic order, in both directions", []() {
+    for (const size_t size : {0, 1, 5, 100, 10000}) {
+      const std::vector<Key> data = generateRandomKeys(size);
+      const std::set<Key> reference(data.begin(), data.end());
+      const StaticTupleSet<uint32_t, uint32_t, uint64_t> ts(data.begin(), data.end());
+
+      expect(ts.size() == reference.size());
+      expect(std::vector<Key>(ts.begin(), ts.end()) == std::vector<Key>(reference.begin(), reference.end()));
+
+      std::vector<Key> backward;
+      for (auto it = ts.end(); it != ts.begin();) {
+        backward.push_back(*--it);
+      }
+      expect(std::equal(backward.begin(), backward.end(), reference.rbegin()));
+    }
+  });
+
+  it("supports lookups on whole tuples", []() {
+    const std::vector<Key> data = generateRandomKeys(10000);
+    const std::set<Key> reference(data.begin(), data.end());
+    const StaticTupleSet<uint32_t, uint32_t, uint64_t> ts(data.begin(), data.end());
+
+    for (const Key &key : data) {
+      expect(ts.contains(key));
+      expect(*ts.find(key) == key);
+    }
+
+    for (const Key &key : generateRandomKeys(10000)) {
+      expect(ts.contains(key) == (reference.count(key) != 0));
+
+      const auto lower = reference.lower_bound(key);
+      expect((lower == reference.end()) ? (ts.lowerBound(key) == ts.end()) : (*ts.lowerBound(key) == *lower));
+
+      const auto upper = reference.upper_bound(key);
+      expect((upper == reference.end()) ? (ts.upperBound(key) == ts.end()) : (*ts.upperBound(key) == *upper));
+    }
+  });
+
+  it("answers queries on a prefix of the columns", []() {
+    const std::vector<Key> data = generateRandomKeys(10000);
+    const std::set<Key> reference(data.begin(), data.end());
+    const StaticTupleSet<uint32_t, uint32_t, uint64_t> ts(data.begin(), data.end());
+
+    for (uint32_t x = 0; x <= 102; x++) {
+      const auto range = ts.equal_range_prefix(x);
+      const auto first = reference.lower_bound(Key(x, 0, 0));
+      const auto last = reference.lower_bound(Key(x + 1, 0, 0));
+
+      expect(std::vector<Key>(range.first, range.second) == std::vector<Key>(first, last));
+      expect(ts.countPrefix(x) == static_cast<size_t>(std::distance(first, last)));
+
+      for (auto it = range.first; it != range.second; ++it) {
+        expect(it.get<0>() == x);
+      }
+
+      for (uint32_t y = 0; y <= 11; y++) {
+        const auto range = ts.equalRangePrefix(x, y);
+        const auto first = reference.lower_bound(Key(x, y, 0));
+        const auto last = reference.upper_bound(Key(x, y, UINT64_MAX));
+
+        expect(std::vector<Key>(range.first, range.second) == std::vector<Key>(first, last));
+        expect(ts.countPrefix(x, y) == static_cast<size_t>(std::distance(first, last)));
+      }
+    }
+
+    const auto all = ts.equal_range_prefix();
+    expect(all.first == ts.begin() && all.second == ts.end());
+  });
+
+  it("compares prefix values of other types by value", []() {
+    const StaticTupleSet<uint32_t, std::string> ts({std::make_tuple(0u, std::string("a")),
+                                                    std::make_tuple(7u, std::string("b")),
+                                                    std::make_tuple(7u, std::string("c")),
+                                                    std::make_tuple(4000000000u, std::string("d"))});
+
+    expect(ts.countPrefix(-294967296) == 0);
+    expect(ts.countPrefix(-1) == 0);
+    expect(ts.countPrefix(4000000000LL) == 1);
+    expect(ts.countPrefix(7) == 2);
+    expect(ts.countPrefix(7.5) == 0);
+    expect(ts.countPrefix(7, "b") == 1);
+
+    const auto negative = ts.equal_range_prefix(-1);
+    expect(negative.first == ts.begin() && negative.second == ts.begin());
+
+    const auto huge = ts.equal_range_prefix(1LL << 40);
+    expect(huge.first == ts.end() && huge.second == ts.end());
+  });
+
+  it("reads single bool columns", []() {
+    const StaticTupleSet<int, bool> ts({std::make_tuple(1, true), std::make_tuple(2, false), std::make_tuple(3, true)});
+
+    std::vector<bool> flags;
+    for (auto it = ts.begin(); it != ts.end(); ++it) {
+      const bool flag = it.get<1>();
+      flags.push_back(flag);
+    }
+
+    expect(flags == std::vector<bool>({true, false, true}));
+    expect(ts.find(std::make_tuple(2, false)).get<1>() == false);
+    expect(ts.countPrefix(3, true) == 1);
+  });
+});
@@ -31,4 +31,37 @@ describe("unordered iteration", []() {
       expect(data == unordered);
     }
   });
+
+  it("supports random access", []() {
+    const std::vector<int> data = generateRandomVector(10000);
+
+    for (const StaticSetLayout layout : {StaticSetLayout::Tree, StaticSetLayout::Partitioned}) {
+      const StaticSet<int> ss(data.begin(), data.end(), layout);
+      expect(ss.layout() == layout);
+
+      expect(static_cast<size_t>(ss.uend() - ss.ubegin()) == ss.size());
+      expect(ss.ubegin() + ss.size() == ss.uend());
+      expect(ss.uend() - ss.size() == ss.ubegin());
+
+      std::vector<int> visited;
+      for (StaticSet<int>::UnorderedIterator it = ss.ubegin(); it != ss.uend(); ++it) {
+        visited.push_back(*it);
+      }
+
+      for (size_t i = 0; i < visited.size(); i += 97) {
+        const StaticSet<int>::UnorderedIterator it = ss.ubegin() + i;
+        expect(ss.ubegin()[i] == visited[i]);
+        expect(*it == visited[i]);
+        expect(static_cast<size_t>(it - ss.ubegin()) == i);
+        expect(ss.ubegin() <= it && it < ss.uend());
+
+        StaticSet<int>::UnorderedIterator prev = ss.uend() - (visited.size() - i);
+        expect(prev == it);
+        if (i > 0) {
+          --prev;
+          expect(*prev == visited[i - 1]);
+        }
+      }
+    }
+  });
 });
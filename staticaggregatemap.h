@@ -0,0 +1,265 @@
+#ifndef LIBSTATICSET_STATICAGGREGATEMAP_H
+#define LIBSTATICSET_STATICAGGREGATEMAP_H
+
+#include "staticset.h"
+
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+/* Aggregate operations for StaticAggregateMap. Each lifts a value into a Result, and combines Results associatively.
+ * Invertible operations also provide uncombine, such that uncombine(combine(x, y), x) == y, and are answered from
+ * prefix aggregates; the others must be idempotent, and are answered from a sparse table */
+
+template <class V> struct StaticSum {
+  typedef V Result;
+
+  static const bool invertible = true;
+
+  static Result identity() { return Result(); }
+  static Result lift(const V &value) { return value; }
+  static Result combine(const Result &x, const Result &y) { return x + y; }
+  static Result uncombine(const Result &total, const Result &prefix) { return total - prefix; }
+};
+
+template <class V> struct StaticCount {
+  typedef size_t Result;
+
+  static const bool invertible = true;
+
+  static Result identity() { return 0; }
+  static Result lift(const V &) { return 1; }
+  static Result combine(const Result &x, const Result &y) { return x + y; }
+  static Result uncombine(const Result &total, const Result &prefix) { return total - prefix; }
+};
+
+/* The minimum over an empty range is std::numeric_limits<V>::max() */
+template <class V> struct StaticMin {
+  typedef V Result;
+
+  static const bool invertible = false;
+
+  static Result identity() { return std::numeric_limits<V>::max(); }
+  static Result lift(const V &value) { return value; }
+  static Result combine(const Result &x, const Result &y) { return std::min(x, y); }
+};
+
+/* The maximum over an empty range is std::numeric_limits<V>::lowest() */
+template <class V> struct StaticMax {
+  typedef V Result;
+
+  static const bool invertible = false;
+
+  static Result identity() { return std::numeric_limits<V>::lowest(); }
+  static Result lift(const V &value) { return value; }
+  static Result combine(const Result &x, const Result &y) { return std::max(x, y); }
+};
+
+/* Aggregates over ranges [first, last) of a sequence, for invertible operations: the difference of two prefix
+ * aggregates */
+template <class Aggregate> class StaticPrefixAggregates {
+  typedef typename Aggregate::Result Result;
+
+  /* prefix[i] aggregates the first i elements */
+  std::vector<Result> prefix;
+
+public:
+  StaticPrefixAggregates() : prefix(1, Aggregate::identity()) { ; }
+
+  explicit StaticPrefixAggregates(const std::vector<Result> &sequence) {
+    prefix.reserve(sequence.size() + 1);
+    prefix.push_back(Aggregate::identity());
+
+    for (const Result &result : sequence) {
+      prefix.push_back(Aggregate::combine(prefix.back(), result));
+    }
+  }
+
+  StaticPrefixAggregates(const StaticPrefixAggregates &other) = default;
+
+  /* A moved-from instance aggregates the empty sequence */
+  StaticPrefixAggregates(StaticPrefixAggregates &&other) : prefix(std::move(other.prefix)) {
+    other.prefix.assign(1, Aggregate::identity());
+  }
+
+  StaticPrefixAggregates &operator=(const StaticPrefixAggregates &other) = default;
+
+  StaticPrefixAggregates &operator=(StaticPrefixAggregates &&other) {
+    if (this != &other) {
+      prefix = std::move(other.prefix);
+      other.prefix.assign(1, Aggregate::identity());
+    }
+    return *this;
+  }
+
+  Result query(size_t first, size_t last) const {
+    assert(first <= last && last < prefix.size());
+    return Aggregate::uncombine(prefix[last], prefix[first]);
+  }
+};
+
+/* Aggregates over ranges [first, last) of a sequence, for idempotent operations: any range is covered by two
+ * (possibly overlapping) ranges whose length is a power of two, each of which is aggregated ahead of time */
+template <class Aggregate> class StaticSparseTableAggregates {
+  typedef typename Aggregate::Result Result;
+
+  /* levels[k][i] aggregates the 2^k elements starting at i */
+  std::vector<std::vector<Result>> levels;
+
+public:
+  StaticSparseTableAggregates() { ; }
+
+  explicit StaticSparseTableAggregates(const std::vector<Result> &sequence) {
+    if (sequence.empty()) {
+      return;
+    }
+
+    levels.push_back(sequence);
+
+    for (size_t width = 2; width <= sequence.size(); width *= 2) {
+      const std::vector<Result> &previous = levels.back();
+      std::vector<Result> level;
+      level.reserve(sequence.size() - width + 1);
+
+      for (size_t i = 0; i + width <= sequence.size(); i++) {
+        level.push_back(Aggregate::combine(previous[i], previous[i + width / 2]));
+      }
+
+      levels.push_back(std::move(level));
+    }
+  }
+
+  Result query(size_t first, size_t last) const {
+    assert(first <= last);
+
+    if (first == last) {
+      return Aggregate::identity();
+    }
+
+    const size_t level = StaticSetTree::bitLength(last - first) - 1;
+    return Aggregate::combine(levels[level][first], levels[level][last - (size_t(1) << level)]);
+  }
+};
+
+/* A static map from keys to values which, in addition to lookups, aggregates the values of all keys in a range in
+ * constant time beyond the two bound lookups. The keys are held in a StaticSet; the values, and the auxiliary
+ * aggregate structure, are indexed by the rank of their key */
+template <class Key, class Value, class Aggregate = StaticSum<Value>, class Compare = std::less<Key>>
+class StaticAggregateMap {
+  typedef StaticSet<Key, Compare> Keys;
+  typedef typename Aggregate::Result Result;
+  typedef typename std::conditional<Aggregate::invertible, StaticPrefixAggregates<Aggregate>,
+                                    StaticSparseTableAggregates<Aggregate>>::type Aggregates;
+
+  /* Filled in while constructing keys, so must be declared first */
+  std::vector<Value> values;
+  Aggregates aggregates;
+
+  Keys keys;
+
+  static Keys initialize(std::vector<std::pair<Key, Value>> pairs, std::vector<Value> &values, Aggregates &aggregates,
+                         StaticSetLayout layout, const Compare &compare) {
+    /* When keys are duplicated, the first occurrence in the input wins */
+    std::stable_sort(pairs.begin(), pairs.end(),
+                     [&](const std::pair<Key, Value> &x, const std::pair<Key, Value> &y) {
+                       return compare(x.first, y.first);
+                     });
+
+    std::vector<Key> sorted_keys;
+    std::vector<Result> lifted;
+
+    for (size_t i = 0; i < pairs.size(); i++) {
+      if (i != 0 && !compare(sorted_keys.back(), pairs[i].first)) {
+        continue;
+      }
+
+      sorted_keys.push_back(std::move(pairs[i].first));
+      lifted.push_back(Aggregate::lift(pairs[i].second));
+      values.push_back(std::move(pairs[i].second));
+    }
+
+    aggregates = Aggregates(lifted);
+    return Keys(std::move(sorted_keys), layout, compare, typename Keys::SortedUnique());
+  }
+
+public:
+  typedef typename Keys::OrderedIterator OrderedIterator;
+
+  StaticAggregateMap() { ; }
+
+  template <class Iter>
+  StaticAggregateMap(Iter first, Iter last, const Compare &comp = Compare())
+      : keys(initialize(std::vector<std::pair<Key, Value>>(first, last), values, aggregates,
+                        StaticSetLayout::Automatic, comp)) {
+    ;
+  }
+
+  template <class Iter>
+  StaticAggregateMap(Iter first, Iter last, StaticSetLayout layout, const Compare &comp = Compare())
+      : keys(initialize(std::vector<std::pair<Key, Value>>(first, last), values, aggregates, layout, comp)) {
+    ;
+  }
+
+  explicit StaticAggregateMap(std::vector<std::pair<Key, Value>> &&pairs, const Compare &comp = Compare())
+      : keys(initialize(std::move(pairs), values, aggregates, StaticSetLayout::Automatic, comp)) {
+    ;
+  }
+
+  StaticAggregateMap(std::vector<std::pair<Key, Value>> &&pairs, StaticSetLayout layout,
+                     const Compare &comp = Compare())
+      : keys(initialize(std::move(pairs), values, aggregates, layout, comp)) {
+    ;
+  }
+
+  StaticAggregateMap(std::initializer_list<std::pair<Key, Value>> list, const Compare &comp = Compare())
+      : keys(initialize(std::vector<std::pair<Key, Value>>(list), values, aggregates, StaticSetLayout::Automatic,
+                        comp)) {
+    ;
+  }
+
+  StaticAggregateMap(std::initializer_list<std::pair<Key, Value>> list, StaticSetLayout layout,
+                     const Compare &comp = Compare())
+      : keys(initialize(std::vector<std::pair<Key, Value>>(list), values, aggregates, layout, comp)) {
+    ;
+  }
+
+  size_t size() const { return keys.size(); }
+
+  bool empty() const { return keys.empty(); }
+
+  /* The set of keys. Its ordered iterators may be passed to value() */
+  const Keys &keySet() const { return keys; }
+
+  const Value &value(const OrderedIterator &iterator) const {
+    assert(iterator != keys.end());
+    return values[keys.rank(iterator)];
+  }
+
+  bool contains(const Key &key) const { return keys.contains(key); }
+
+  OrderedIterator find(const Key &key) const { return keys.find(key); }
+
+  const Value &at(const Key &key) const {
+    const OrderedIterator iterator = keys.find(key);
+
+    if (iterator == keys.end()) {
+      throw std::out_of_range("StaticAggregateMap::at");
+    }
+
+    return value(iterator);
+  }
+
+  /* The aggregate of the values of all keys in [low, high) */
+  Result aggregate(const Key &low, const Key &high) const {
+    if (!keys.valueComp()(low, high)) {
+      return Aggregate::identity();
+    }
+
+    return aggregates.query(keys.rank(keys.lower_bound(low)), keys.rank(keys.lower_bound(high)));
+  }
+
+  /* The aggregate of the values of all keys */
+  Result aggregate() const { return aggregates.query(0, size()); }
+};
+
+#endif
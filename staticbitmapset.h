@@ -0,0 +1,345 @@
+#ifndef LIBSTATICSET_STATICBITMAPSET_H
+#define LIBSTATICSET_STATICBITMAPSET_H
+
+#include "staticset.h"
+
+#include <stdexcept>
+
+/* A static set of integers drawn densely from a bounded range, such as port numbers or shard IDs: one bit per value in
+ * [min, max], with a popcount rank directory. Membership is a single bit test, bounds and neighbours are found a word
+ * at a time, and ranks take constant time.
+ *
+ * The elements aren't stored as such, so iterators yield them by value. That makes them input iterators as far as the
+ * standard is concerned, although they can also be decremented (which is all std::reverse_iterator needs) */
+template <class T> class StaticBitmapSet {
+  typedef StaticSetRadix<T, std::less<T>> Radix;
+
+  static_assert(Radix::supported, "StaticBitmapSet requires integral elements");
+
+public:
+  /* Values are accepted only if they span fewer than this many values per element. At that sparsity the bitmap takes
+   * 32 bytes per element and its lower_bound is merely on par with a partitioned StaticSet's (see make bench); any
+   * sparser, and it loses on both memory and latency */
+  static const uint64_t max_sparsity = 128;
+
+private:
+  /* When searching for the next set bit, the number of words to scan linearly before falling back to a binary search
+   * of the rank directory */
+  static const size_t scan_words = 8;
+
+#if defined(__GNUC__)
+  static size_t popCount(uint64_t word) { return __builtin_popcountll(word); }
+  static size_t countTrailingZeros(uint64_t word) { return __builtin_ctzll(word); }
+  static size_t highestBit(uint64_t word) { return 63 - __builtin_clzll(word); }
+#else
+  static size_t popCount(uint64_t word) {
+    size_t count = 0;
+    for (; word != 0; word &= word - 1) {
+      count++;
+    }
+    return count;
+  }
+
+  static size_t countTrailingZeros(uint64_t word) { return popCount((word & -word) - 1); }
+
+  static size_t highestBit(uint64_t word) { return StaticSetTree::bitLength(word) - 1; }
+#endif
+
+  /* The element with radix bits b is represented by bit b - low, for b in [low, low + universe) */
+  uint64_t low = 0;
+  size_t universe = 0;
+
+  /* ranks[w] is the number of bits set in words[0, w); the final entry is the size of the set */
+  std::vector<uint64_t> words;
+  std::vector<size_t> ranks = std::vector<size_t>(1, 0);
+
+  bool test(size_t position) const { return ((words[position / 64] >> (position % 64)) & 1); }
+
+  /* The number of elements represented by bits strictly before the given position */
+  size_t rankAt(size_t position) const {
+    const size_t word = position / 64;
+    const size_t offset = position % 64;
+    return ranks[word] + ((offset == 0) ? 0 : popCount(words[word] & ((uint64_t(1) << offset) - 1)));
+  }
+
+  /* The position of the element with the given rank, which must be less than the size of the set */
+  size_t select(size_t rank) const {
+    const size_t word = (std::upper_bound(ranks.begin(), ranks.end(), rank) - ranks.begin()) - 1;
+
+    uint64_t bits = words[word];
+    for (size_t skip = rank - ranks[word]; skip != 0; skip--) {
+      bits &= bits - 1;
+    }
+
+    return 64 * word + countTrailingZeros(bits);
+  }
+
+  /* The position of the first set bit at or after the given position, or the universe size if there is none. The
+   * common dense case is answered from the word at hand or its immediate successors; otherwise the rank directory
+   * skips over long runs of empty words */
+  size_t nextPosition(size_t position) const {
+    if (position >= universe) {
+      return universe;
+    }
+
+    const size_t word = position / 64;
+    const uint64_t bits = words[word] & (~uint64_t(0) << (position % 64));
+
+    if (bits != 0) {
+      return 64 * word + countTrailingZeros(bits);
+    }
+
+    const size_t scan_end = std::min(words.size(), word + 1 + scan_words);
+    for (size_t next = word + 1; next < scan_end; next++) {
+      if (words[next] != 0) {
+        return 64 * next + countTrailingZeros(words[next]);
+      }
+    }
+
+    const size_t rank = ranks[scan_end];
+    return ((rank == size()) ? universe : select(rank));
+  }
+
+  /* The position of the last set bit strictly before the given position, which must exist */
+  size_t previousPosition(size_t position) const {
+    const size_t word = position / 64;
+    const size_t offset = position % 64;
+    const uint64_t bits = ((offset == 0) ? 0 : words[word] & ((uint64_t(1) << offset) - 1));
+
+    if (bits != 0) {
+      return 64 * word + highestBit(bits);
+    }
+
+    assert(ranks[word] != 0);
+    return select(ranks[word] - 1);
+  }
+
+  /* Where the needle falls relative to the universe: -1 if before it (or if the set is empty), 1 if after it,
+   * otherwise 0, with its position */
+  int locate(const T &needle, size_t &position) const {
+    const uint64_t bits = Radix::toBits(needle);
+
+    if (universe == 0 || bits < low) {
+      return -1;
+    }
+
+    if (bits - low >= universe) {
+      return 1;
+    }
+
+    position = bits - low;
+    return 0;
+  }
+
+  void reset() {
+    low = 0;
+    universe = 0;
+    words.clear();
+    ranks.assign(1, 0);
+  }
+
+  void initialize(std::vector<T> values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    reset();
+
+    if (values.empty()) {
+      return;
+    }
+
+    low = Radix::toBits(values.front());
+    const uint64_t span = Radix::toBits(values.back()) - low;
+
+    if (span / values.size() >= max_sparsity) {
+      throw std::invalid_argument("StaticBitmapSet: values are too sparse for a bitmap");
+    }
+
+    universe = span + 1;
+
+    words.assign((universe + 63) / 64, 0);
+    for (const T &value : values) {
+      const size_t position = Radix::toBits(value) - low;
+      words[position / 64] |= uint64_t(1) << (position % 64);
+    }
+
+    ranks.resize(words.size() + 1);
+    for (size_t word = 0; word < words.size(); word++) {
+      ranks[word + 1] = ranks[word] + popCount(words[word]);
+    }
+  }
+
+public:
+  class OrderedIterator {
+    friend class StaticBitmapSet;
+
+    const StaticBitmapSet *ss;
+    size_t position;
+
+    OrderedIterator(const StaticBitmapSet &ss, size_t position) : ss(&ss), position(position) { ; }
+
+  public:
+    typedef std::ptrdiff_t difference_type;
+    typedef T value_type;
+    typedef void pointer;
+    typedef T reference;
+    typedef std::input_iterator_tag iterator_category;
+
+    reference operator*() const {
+      assert(position < ss->universe);
+      return Radix::fromBits(ss->low + position);
+    }
+
+    bool operator==(const OrderedIterator &other) const { return (ss == other.ss && position == other.position); }
+
+    bool operator!=(const OrderedIterator &other) const { return !(*this == other); }
+
+    OrderedIterator &operator++() {
+      assert(position < ss->universe);
+      position = ss->nextPosition(position + 1);
+      return *this;
+    }
+
+    OrderedIterator operator++(int) {
+      OrderedIterator prev = *this;
+      ++(*this);
+      return prev;
+    }
+
+    OrderedIterator &operator--() {
+      assert(*this != ss->begin());
+      position = ss->previousPosition(position);
+      return *this;
+    }
+
+    OrderedIterator operator--(int) {
+      OrderedIterator prev = *this;
+      --(*this);
+      return prev;
+    }
+  };
+
+  StaticBitmapSet() { ; }
+
+  /* These throw std::invalid_argument if the values are too sparse; see max_sparsity */
+
+  template <class Iter> StaticBitmapSet(Iter first, Iter last) { initialize(std::vector<T>(first, last)); }
+
+  explicit StaticBitmapSet(std::vector<T> &&values) { initialize(std::move(values)); }
+
+  StaticBitmapSet(std::initializer_list<T> list) { initialize(std::vector<T>(list)); }
+
+  StaticBitmapSet(const StaticBitmapSet &other) = default;
+
+  StaticBitmapSet(StaticBitmapSet &&other)
+      : low(other.low), universe(other.universe), words(std::move(other.words)), ranks(std::move(other.ranks)) {
+    other.reset();
+  }
+
+  StaticBitmapSet &operator=(const StaticBitmapSet &other) = default;
+
+  StaticBitmapSet &operator=(StaticBitmapSet &&other) {
+    if (this != &other) {
+      low = other.low;
+      universe = other.universe;
+      words = std::move(other.words);
+      ranks = std::move(other.ranks);
+      other.reset();
+    }
+    return *this;
+  }
+
+  size_t size() const { return ranks.back(); }
+
+  bool empty() const { return (size() == 0); }
+
+  /* The number of bytes of heap storage used to represent the elements of the set */
+  size_t memoryUsage() const { return (words.size() * sizeof(uint64_t) + ranks.size() * sizeof(size_t)); }
+
+  OrderedIterator begin() const { return OrderedIterator(*this, 0); }
+
+  OrderedIterator end() const { return OrderedIterator(*this, universe); }
+
+  bool contains(const T &needle) const {
+    size_t position;
+    return (locate(needle, position) == 0 && test(position));
+  }
+
+  OrderedIterator find(const T &needle) const {
+    size_t position;
+    return ((locate(needle, position) == 0 && test(position)) ? OrderedIterator(*this, position) : end());
+  }
+
+  OrderedIterator lower_bound(const T &needle) const {
+    size_t position;
+    const int where = locate(needle, position);
+    return ((where < 0) ? begin() : (where > 0) ? end() : OrderedIterator(*this, nextPosition(position)));
+  }
+
+  OrderedIterator lowerBound(const T &needle) const { return lower_bound(needle); }
+
+  OrderedIterator upper_bound(const T &needle) const {
+    size_t position;
+    const int where = locate(needle, position);
+    return ((where < 0) ? begin() : (where > 0) ? end() : OrderedIterator(*this, nextPosition(position + 1)));
+  }
+
+  OrderedIterator upperBound(const T &needle) const { return upper_bound(needle); }
+
+  /* The in-order neighbours of a value, as for StaticSet. Each returns end() if there is no such element */
+
+  /* The largest element LT the needle */
+  OrderedIterator predecessor(const T &needle) const {
+    size_t position;
+    const int where = locate(needle, position);
+
+    if (where < 0 || (where == 0 && position == 0)) {
+      return end();
+    }
+
+    return OrderedIterator(*this, previousPosition((where > 0) ? universe : position));
+  }
+
+  /* The smallest element GT the needle; equivalent to upper_bound */
+  OrderedIterator successor(const T &needle) const { return upper_bound(needle); }
+
+  /* The largest element LTE the needle */
+  OrderedIterator floor(const T &needle) const {
+    size_t position;
+    const int where = locate(needle, position);
+
+    if (where < 0) {
+      return end();
+    }
+
+    return OrderedIterator(*this, previousPosition((where > 0) ? universe : position + 1));
+  }
+
+  /* The smallest element GTE the needle; equivalent to lower_bound */
+  OrderedIterator ceiling(const T &needle) const { return lower_bound(needle); }
+
+  /* The element nearest the needle, preferring the smaller of two equidistant elements */
+  OrderedIterator nearest(const T &needle) const {
+    const OrderedIterator below = floor(needle);
+    const OrderedIterator above = successor(needle);
+
+    if (below == end() || above == end()) {
+      return ((below == end()) ? above : below);
+    }
+
+    if (*below == needle) {
+      return below;
+    }
+
+    typedef StaticSetDistance<T> Distance;
+    return ((Distance::between(*above, needle) < Distance::between(*below, needle)) ? above : below);
+  }
+
+  /* The number of elements less than the one at the given position; size() for end(). Constant time */
+  size_t rank(const OrderedIterator &iterator) const {
+    assert(iterator.ss == this);
+    return ((iterator.position == universe) ? size() : rankAt(iterator.position));
+  }
+};
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef LIBSTATICSET_STATICMULTISET_H
+#define LIBSTATICSET_STATICMULTISET_H
+
+#include "staticset.h"
+
+#include <utility>
+
+/* A static multiset. Each distinct element is stored once, in a StaticSet, alongside a prefix sum of multiplicities
+ * indexed by rank; an element's count is the difference of adjacent prefix sums, and the number of occurrences in any
+ * range is the difference of the prefix sums at its bounds */
+template <class T, class Compare = std::less<T>, class Allocator = std::allocator<T>> class StaticMultiSet {
+  typedef StaticSet<T, Compare, Allocator> Set;
+  typedef std::vector<T, Allocator> Vector;
+
+  /* prefix[r] is the total multiplicity of the r smallest distinct elements. Filled in while constructing distinct, so
+   * must be declared first */
+  std::vector<size_t> prefix;
+
+  Set distinct;
+
+  static Set initialize(Vector values, std::vector<size_t> &prefix, StaticSetLayout layout, const Compare &compare) {
+    std::sort(values.begin(), values.end(), compare);
+
+    prefix.assign(1, 0);
+
+    size_t deduped_size = 0;
+
+    for (size_t i = 0; i < values.size();) {
+      if (i != deduped_size) {
+        values[deduped_size] = std::move(values[i]);
+      }
+
+      const T &value = values[deduped_size];
+      size_t multiplicity = 1;
+
+      while (++i < values.size() && !compare(value, values[i])) {
+        assert(!compare(values[i], value));
+        multiplicity++;
+      }
+
+      prefix.push_back(prefix.back() + multiplicity);
+      deduped_size++;
+    }
+
+    values.erase(values.begin() + deduped_size, values.end());
+
+    return Set(std::move(values), layout, compare, typename Set::SortedUnique());
+  }
+
+  size_t multiplicity(size_t rank) const { return prefix[rank + 1] - prefix[rank]; }
+
+public:
+  class OrderedIterator {
+    friend class StaticMultiSet;
+
+    const StaticMultiSet<T, Compare, Allocator> &ms;
+    typename Set::OrderedIterator it;
+
+    /* The rank of the current distinct element, and which of its copies we're at */
+    size_t rank;
+    size_t copy;
+
+    OrderedIterator(const StaticMultiSet<T, Compare, Allocator> &ms, typename Set::OrderedIterator it)
+        : ms(ms), it(it), rank(ms.distinct.rank(it)), copy(0) {
+      ;
+    }
+
+  public:
+    typedef size_t difference_type;
+    typedef T value_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+    typedef std::bidirectional_iterator_tag iterator_category;
+
+    reference operator*() const { return *it; }
+
+    pointer operator->() const { return &*it; }
+
+    bool operator==(const OrderedIterator &other) const { return (it == other.it && copy == other.copy); }
+
+    bool operator!=(const OrderedIterator &other) const { return !(*this == other); }
+
+    OrderedIterator &operator++() {
+      if (++copy == ms.multiplicity(rank)) {
+        ++it;
+        rank++;
+        copy = 0;
+      }
+
+      return *this;
+    }
+
+    OrderedIterator operator++(int) {
+      OrderedIterator prev = *this;
+      ++(*this);
+      return prev;
+    }
+
+    OrderedIterator &operator--() {
+      if (copy == 0) {
+        --it;
+        rank--;
+        copy = ms.multiplicity(rank);
+      }
+
+      copy--;
+      return *this;
+    }
+
+    OrderedIterator operator--(int) {
+      OrderedIterator prev = *this;
+      --(*this);
+      return prev;
+    }
+  };
+
+  StaticMultiSet() : prefix(1, 0) { ; }
+
+  template <class Iter>
+  StaticMultiSet(Iter first, Iter last, const Compare &comp = Compare(), const Allocator &alloc = Allocator())
+      : distinct(initialize(Vector(first, last, alloc), prefix, StaticSetLayout::Automatic, comp)) {
+    ;
+  }
+
+  template <class Iter>
+  StaticMultiSet(Iter first, Iter last, StaticSetLayout layout, const Compare &comp = Compare(),
+                 const Allocator &alloc = Allocator())
+      : distinct(initialize(Vector(first, last, alloc), prefix, layout, comp)) {
+    ;
+  }
+
+  explicit StaticMultiSet(std::vector<T, Allocator> &&values, const Compare &comp = Compare())
+      : distinct(initialize(std::move(values), prefix, StaticSetLayout::Automatic, comp)) {
+    ;
+  }
+
+  StaticMultiSet(std::vector<T, Allocator> &&values, StaticSetLayout layout, const Compare &comp = Compare())
+      : distinct(initialize(std::move(values), prefix, layout, comp)) {
+    ;
+  }
+
+  StaticMultiSet(std::initializer_list<T> list, const Compare &comp = Compare(), const Allocator &alloc = Allocator())
+      : distinct(initialize(Vector(list, alloc), prefix, StaticSetLayout::Automatic, comp)) {
+    ;
+  }
+
+  StaticMultiSet(std::initializer_list<T> list, StaticSetLayout layout, const Compare &comp = Compare(),
+                 const Allocator &alloc = Allocator())
+      : distinct(initialize(Vector(list, alloc), prefix, layout, comp)) {
+    ;
+  }
+
+  StaticMultiSet(const StaticMultiSet &other) = default;
+
+  StaticMultiSet(StaticMultiSet &&other) : prefix(std::move(other.prefix)), distinct(std::move(other.distinct)) {
+    other.prefix.assign(1, 0);
+  }
+
+  StaticMultiSet &operator=(const StaticMultiSet &other) = default;
+
+  StaticMultiSet &operator=(StaticMultiSet &&other) {
+    if (this != &other) {
+      prefix = std::move(other.prefix);
+      distinct = std::move(other.distinct);
+      other.prefix.assign(1, 0);
+    }
+    return *this;
+  }
+
+  /* The number of elements, counting multiplicity */
+  size_t size() const { return prefix.back(); }
+
+  /* The number of distinct elements */
+  size_t distinctSize() const { return distinct.size(); }
+
+  bool empty() const { return (size() == 0); }
+
+  Compare valueComp() const { return distinct.valueComp(); }
+
+  Compare value_comp() const { return valueComp(); }
+
+  /* The set of distinct elements */
+  const Set &set() const { return distinct; }
+
+  OrderedIterator begin() const { return OrderedIterator(*this, distinct.begin()); }
+
+  OrderedIterator end() const { return OrderedIterator(*this, distinct.end()); }
+
+  bool contains(const T &needle) const { return distinct.contains(needle); }
+
+  size_t count(const T &needle) const {
+    const typename Set::OrderedIterator it = distinct.find(needle);
+    return ((it == distinct.end()) ? 0 : multiplicity(distinct.rank(it)));
+  }
+
+  /* The number of elements in [low, high), counting multiplicity */
+  size_t count(const T &low, const T &high) const {
+    if (!valueComp()(low, high)) {
+      return 0;
+    }
+
+    return prefix[distinct.rank(distinct.lower_bound(high))] - prefix[distinct.rank(distinct.lower_bound(low))];
+  }
+
+  /* An iterator pointing at the first copy of an element equal to the query, or end() */
+  OrderedIterator find(const T &needle) const { return OrderedIterator(*this, distinct.find(needle)); }
+
+  OrderedIterator lower_bound(const T &needle) const { return OrderedIterator(*this, distinct.lower_bound(needle)); }
+
+  OrderedIterator lowerBound(const T &needle) const { return lower_bound(needle); }
+
+  OrderedIterator upper_bound(const T &needle) const { return OrderedIterator(*this, distinct.upper_bound(needle)); }
+
+  OrderedIterator upperBound(const T &needle) const { return upper_bound(needle); }
+
+  std::pair<OrderedIterator, OrderedIterator> equal_range(const T &needle) const {
+    return std::make_pair(lower_bound(needle), upper_bound(needle));
+  }
+
+  std::pair<OrderedIterator, OrderedIterator> equalRange(const T &needle) const { return equal_range(needle); }
+};
+
+#endif
@@ -2,17 +2,93 @@
 #define LIBSTATICSET_STATICSET_H
 
 #include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <initializer_list>
 #include <iterator>
 #include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-template <class T, class Compare = std::less<T>, class Allocator = std::allocator<T>> class StaticSet {
-  typedef std::vector<T> Vector;
-  typedef typename Vector::iterator VectorIterator;
+/* Physical arrangement of a StaticSet's elements. Every layout exposes exactly the same interface and ordered
+ * semantics; they differ only in memory footprint and lookup cost */
+enum class StaticSetLayout {
+  /* Pick the most appropriate layout based on the type and the contents of the set */
+  Automatic,
 
-  static const size_t size_t_bits = sizeof(size_t) * CHAR_BIT;
+  /* A single implicit search tree, stored in breadth-first (Eytzinger) order */
+  Tree,
+
+  /* Integral keys only: a top-level table indexed by the high bits of the key, pointing at small independent
+   * search trees stored contiguously. Falls back to Tree when the key type is unsuitable or the set is too small
+   * to be partitioned */
+  Partitioned
+};
+
+/* Maps keys onto unsigned 64-bit integers such that the mapping is monotonic with respect to the comparator. Only
+ * integral keys ordered by std::less admit such a mapping; other types are restricted to comparison-based layouts */
+template <class T, class Compare, class Enable = void> struct StaticSetRadix {
+  static const bool supported = false;
+
+  static uint64_t toBits(const T &) { return 0; }
+};
+
+template <class T>
+struct StaticSetRadix<T, std::less<T>,
+                      typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+  typedef typename std::make_unsigned<T>::type Unsigned;
+
+  static const bool supported = true;
+
+  /* Flipping the sign bit of a two's complement integer yields an unsigned integer of the same order */
+  static Unsigned bias() {
+    return (std::is_signed<T>::value ? static_cast<Unsigned>(Unsigned(1) << (sizeof(T) * CHAR_BIT - 1)) : 0);
+  }
+
+  static uint64_t toBits(T value) { return static_cast<Unsigned>(static_cast<Unsigned>(value) ^ bias()); }
+
+  static T fromBits(uint64_t bits) {
+    return static_cast<T>(static_cast<Unsigned>(static_cast<Unsigned>(bits) ^ bias()));
+  }
+};
+
+/* The distance between two keys, for nearest(). It is measured by value, whatever the set's comparator, so that
+ * std::less and std::greater agree on which element is nearest. Integral keys are measured as unsigned 64-bit
+ * differences, which can't overflow; other types must support subtraction and operator<, and their differences must be
+ * ordered by operator< */
+template <class T, class Enable = void> struct StaticSetDistance {
+  static T between(const T &x, const T &y) { return ((x < y) ? y - x : x - y); }
+};
+
+template <class T>
+struct StaticSetDistance<T,
+                         typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+  typedef StaticSetRadix<T, std::less<T>> Radix;
+
+  static uint64_t between(T x, T y) {
+    const uint64_t x_bits = Radix::toBits(x);
+    const uint64_t y_bits = Radix::toBits(y);
+    return ((x_bits < y_bits) ? y_bits - x_bits : x_bits - y_bits);
+  }
+};
+
+/* Index arithmetic for an implicit binary search tree of n nodes stored in breadth-first (Eytzinger) order, i.e. the
+ * children of node i are nodes 2i + 1 and 2i + 2 */
+struct StaticSetTree {
+  /* The number of significant bits in value */
+  static size_t bitLength(uint64_t value) {
+    size_t length = 0;
+    while (value != 0) {
+      value >>= 1;
+      length++;
+    }
+    return length;
+  }
 
   static size_t goUp(size_t index) { return (index - 1) / 2; }
   static size_t goLeft(size_t index) { return 2 * index + 1; }
@@ -40,100 +116,483 @@ template <class T, class Compare = std::less<T>, class Allocator = std::allocato
     }
   }
 
-  const Compare compare;
+  /* The node following the given one in the ordered sequence, or n if it is the last. Three cases: (i) The node has a
+   * right subtree; the next node is the leftmost descendant of the right subtree; (ii) The node has no right subtree,
+   * but it is in the left subtree of some ancestor; the lowest such ancestor is the next node; (iii) The node is the
+   * rightmost node of the tree */
+  static size_t successor(size_t index, size_t n) {
+    const size_t right = goRight(index);
+
+    if (right < n) {
+      /* Case (i) */
+      return digLeft(right, n);
+    }
+
+    while (index != 0 && isRight(index)) {
+      index = goUp(index);
+    }
+
+    /* Case (ii) or (iii) */
+    return ((index == 0) ? n : goUp(index));
+  }
+
+  /* The position of the given node in the ordered sequence. Our trees are as short as possible, with every level
+   * except possibly the bottommost complete and the bottommost filled from left to right (hence node indices ranging
+   * from 0 to n - 1 with no gaps). Thus a node's rank follows from its depth and its offset within its level: a
+   * bottommost node is preceded by as many nodes from the complete tree above as from the bottommost level, while any
+   * other node is preceded by its rank within the complete tree above, plus those bottommost nodes that fall to the
+   * left of its position */
+  static size_t rank(size_t index, size_t n) {
+    assert(index < n);
+
+    const size_t height = bitLength(n);
+    const size_t depth = bitLength(index + 1) - 1;
+    const size_t offset = index + 1 - (size_t(1) << depth);
+
+    if (depth == height - 1) {
+      return 2 * offset;
+    }
+
+    const size_t bottom_row_count = n + 1 - (size_t(1) << (height - 1));
+    const size_t split = (2 * offset + 1) << (height - 2 - depth);
+
+    return (split - 1) + std::min(bottom_row_count, split);
+  }
+
+  /* The node preceding the given one in the ordered sequence, or n if it is the first. Symmetric to successor */
+  static size_t predecessor(size_t index, size_t n) {
+    const size_t left = goLeft(index);
+
+    if (left < n) {
+      return digRight(left, n);
+    }
+
+    while (index != 0 && isLeft(index)) {
+      index = goUp(index);
+    }
+
+    return ((index == 0) ? n : goUp(index));
+  }
+
+  /* Index of the smallest element GTE the needle (or GT the needle, if strict) in a tree of n distinct elements, or n
+   * if no such element exists */
+  template <class T, class Compare>
+  static size_t boundIndex(const T *tree, size_t n, const T &needle, bool strict, const Compare &compare) {
+    size_t index = 0;
+    size_t best = n;
+
+    while (index < n) {
+      if (compare(needle, tree[index])) {
+        best = index;
+        index = goLeft(index);
+      } else if (strict || compare(tree[index], needle)) {
+        index = goRight(index);
+      } else {
+        best = index;
+        break;
+      }
+    }
+
+    return best;
+  }
+};
+
+template <class T, class Compare, class Allocator> class StaticMultiSet;
+template <class Key, class Value, class Aggregate, class Compare> class StaticAggregateMap;
+
+template <class T, class Compare = std::less<T>, class Allocator = std::allocator<T>>
+class StaticSet : private StaticSetTree {
+  template <class, class, class> friend class StaticMultiSet;
+  template <class, class, class, class> friend class StaticAggregateMap;
+
+  typedef std::vector<T, Allocator> Vector;
+  typedef typename Vector::iterator VectorIterator;
+  typedef StaticSetRadix<T, Compare> Radix;
+
+  /* A (partition, index) pair, as held by OrderedIterator */
+  typedef std::pair<size_t, size_t> Position;
+
+  static const size_t size_t_bits = sizeof(size_t) * CHAR_BIT;
+
+  /* Automatic layout selection only partitions sets at least this large; smaller trees fit comfortably in cache,
+   * and the top-level table would buy nothing */
+  static const size_t partition_min_size = 4096;
+
+  /* Partitioned layouts aim for subtrees of roughly this many elements, i.e. a descent of five or six levels
+   * spanning only a handful of cache lines */
+  static const size_t partition_target_size = 32;
+
+  /* Batched neighbour queries descend this many trees in lockstep, so that their cache misses overlap */
+  static const size_t batch_lanes = 16;
+
+#if defined(__GNUC__)
+  static void prefetch(const void *address) { __builtin_prefetch(address); }
+#else
+  static void prefetch(const void *) { ; }
+#endif
+
+  Compare compare;
   Vector tree;
-  size_t leftmost;
-  size_t rightmost;
+  StaticSetLayout chosen_layout = StaticSetLayout::Tree;
+
+  /* The tree is stored as a sequence of independent subtrees, one per partition; partition p occupies
+   * tree[partitions[p], partitions[p + 1]). The Tree layout is simply the degenerate case of a single partition */
+  std::vector<size_t> partitions = std::vector<size_t>(2, 0);
+
+  /* For the Partitioned layout, the element with radix bits b belongs to partition (b - radix_low) >> radix_shift, and
+   * all elements have bits in [radix_low, radix_high] */
+  uint64_t radix_low = 0;
+  uint64_t radix_high = 0;
+  size_t radix_shift = 0;
+
+  size_t partitionCount() const { return partitions.size() - 1; }
+  size_t partitionBase(size_t partition) const { return partitions[partition]; }
+  size_t partitionSize(size_t partition) const { return partitions[partition + 1] - partitions[partition]; }
+
+  /* The first non-empty partition at or after the given one (which may be partitionCount() itself), or
+   * partitionCount() if there is none */
+  size_t firstNonEmptyPartition(size_t partition) const {
+    const std::vector<size_t>::const_iterator it =
+        std::upper_bound(partitions.begin() + partition + 1, partitions.end(), partitions[partition]);
+    return (it - partitions.begin()) - 1;
+  }
 
-  void buildTree(size_t index, const VectorIterator slice_begin, const VectorIterator slice_end) {
-    const size_t count = slice_end - slice_begin;
+  /* The last non-empty partition strictly before the given one, or partitionCount() if there is none */
+  size_t lastNonEmptyPartitionBefore(size_t partition) const {
+    const std::vector<size_t>::const_iterator it =
+        std::lower_bound(partitions.begin(), partitions.begin() + partition, partitions[partition]);
+    return ((it == partitions.begin()) ? partitionCount() : (it - partitions.begin()) - 1);
+  }
 
-    assert((count > 0) == (index < tree.size()));
+  /* The partition that would hold the given needle, or partitionCount() if the needle is greater than every element
+   * of the set. Needles less than every element are mapped to the first partition */
+  size_t partitionOf(const T &needle) const {
+    if (chosen_layout != StaticSetLayout::Partitioned) {
+      return 0;
+    }
+
+    const uint64_t bits = Radix::toBits(needle);
 
-    if (count == 0) {
-      return;
+    if (bits < radix_low) {
+      return 0;
     }
 
-    if (count == 1) {
-      tree[index] = *slice_begin;
-      return;
+    if (bits > radix_high) {
+      return partitionCount();
     }
 
-    /* Consider the shortest possible binary tree with n nodes, and with the property that all
-     * levels except possibly the bottommost are complete, and the bottommost level is filled
-     * from left to right. As it happens, this configuration yields the most compact representation
-     * of our search tree as an array, because our node indices would range from 0 to n - 1 with
-     * no gaps */
+    return (bits - radix_low) >> radix_shift;
+  }
 
-    /* The height of the shortest possible binary tree on count nodes */
-    size_t height;
-    for (height = 2; (1 << height) <= count; height++) {
-      ;
+  /* Append the given sorted slice to the tree as an implicit search tree of its own. Every node's position in the
+   * ordered sequence follows directly from its index, so the nodes can be constructed in place, in index order, by
+   * moving each one out of the slice exactly once */
+  void appendTree(const VectorIterator slice_begin, const VectorIterator slice_end) {
+    const size_t count = slice_end - slice_begin;
+
+    for (size_t index = 0; index < count; index++) {
+      tree.emplace_back(std::move(slice_begin[StaticSetTree::rank(index, count)]));
+    }
+  }
+
+  /* Decide how many high bits of the key index the top-level table, given the sorted, deduplicated contents of the
+   * set. Returns false if the set shouldn't (or can't) be partitioned */
+  bool choosePartitioning(const VectorIterator sorted_begin, const VectorIterator sorted_end, StaticSetLayout layout) {
+    const size_t count = sorted_end - sorted_begin;
+
+    if (!Radix::supported || count == 0 || layout == StaticSetLayout::Tree) {
+      return false;
     }
 
-    /* The number of nodes required to yield complete left and right subtrees excluding the
-     * bottommost row */
-    const size_t subtree_size_excluding_bottom = (1 << (height - 2)) - 1;
+    if (layout == StaticSetLayout::Automatic && count < partition_min_size) {
+      return false;
+    }
 
-    /* The number of nodes that could fit into the bottommost row of a tree of the given height*/
-    const size_t bottom_row_size = (1 << (height - 1));
+    radix_low = Radix::toBits(*sorted_begin);
+    radix_high = Radix::toBits(*(sorted_end - 1));
 
-    /* The number of nodes that we will actually be packing into the bottommost row */
-    const size_t bottom_row_count = count - 1 - 2 * subtree_size_excluding_bottom;
+    /* We want roughly count / partition_target_size partitions, but there's no sense in indexing by more bits than
+     * the key range actually spans */
+    const size_t range_bits = bitLength(radix_high - radix_low);
+    const size_t table_bits = std::min(range_bits, bitLength(count / partition_target_size));
 
-    /* If we can pack the entire bottom row into the left subtree (in which case the right subtree
-     * is one unit shorter, but complete), put sufficiently many nodes into the left subtree to do
-     * so. Otherwise, put sufficiently many nodes into the left subtree to make it complete,
-     * leaving the rest for the right subtree */
-    VectorIterator pivot;
-    if (bottom_row_count <= bottom_row_size / 2) {
-      pivot = slice_begin + subtree_size_excluding_bottom + bottom_row_count;
-    } else {
-      pivot = slice_begin + subtree_size_excluding_bottom + bottom_row_size / 2;
+    if (table_bits == 0) {
+      return false;
     }
 
-    tree[index] = *pivot;
+    radix_shift = range_bits - table_bits;
 
-    buildTree(goLeft(index), slice_begin, pivot);
-    buildTree(goRight(index), pivot + 1, slice_end);
+    return true;
   }
 
-  void initialize(Vector scratch) {
+  /* Leave the set empty, as a moved-from set must be */
+  void reset() {
+    tree.clear();
+    chosen_layout = StaticSetLayout::Tree;
+    partitions.assign(2, 0);
+    radix_low = 0;
+    radix_high = 0;
+    radix_shift = 0;
+  }
+
+  void initialize(Vector scratch, StaticSetLayout layout = StaticSetLayout::Automatic) {
     std::sort(scratch.begin(), scratch.end(), compare);
 
     size_t deduped_size = 0;
 
     for (size_t i = 0; i < scratch.size();) {
-      const T &value = scratch[i];
-
       if (i != deduped_size) {
-        scratch[deduped_size] = scratch[i];
+        scratch[deduped_size] = std::move(scratch[i]);
       }
 
+      const T &value = scratch[deduped_size];
+
       while (++i < scratch.size() && !compare(value, scratch[i])) {
-        assert(compare(value, scratch[i]));
+        assert(!compare(scratch[i], value));
       }
 
       deduped_size++;
     }
 
-    tree.resize(deduped_size);
-    buildTree(0, scratch.begin(), scratch.begin() + deduped_size);
+    build(scratch.begin(), scratch.begin() + deduped_size, layout);
+  }
+
+  /* Builds the set from elements which are already sorted and free of duplicates */
+  void build(const VectorIterator sorted_begin, const VectorIterator sorted_end, StaticSetLayout layout) {
+    const size_t deduped_size = sorted_end - sorted_begin;
+
+    tree.clear();
+    partitions.assign(1, 0);
+
+    tree.reserve(deduped_size);
+
+    if (choosePartitioning(sorted_begin, sorted_end, layout)) {
+      chosen_layout = StaticSetLayout::Partitioned;
+
+      const size_t count = ((radix_high - radix_low) >> radix_shift) + 1;
+
+      VectorIterator slice_begin = sorted_begin;
+
+      for (size_t partition = 0; partition < count; partition++) {
+        VectorIterator slice_end = slice_begin;
+        while (slice_end != sorted_end && ((Radix::toBits(*slice_end) - radix_low) >> radix_shift) == partition) {
+          ++slice_end;
+        }
+
+        appendTree(slice_begin, slice_end);
+        partitions.push_back(tree.size());
+
+        slice_begin = slice_end;
+      }
+
+      assert(slice_begin == sorted_end);
+    } else {
+      chosen_layout = StaticSetLayout::Tree;
+      appendTree(sorted_begin, sorted_end);
+      partitions.push_back(tree.size());
+    }
+  }
+
+  /* Index within the given partition of the smallest element GTE the needle (or GT the needle, if strict), or the
+   * partition's size if no such element exists */
+  size_t boundWithin(size_t partition, const T &needle, bool strict) const {
+    return boundIndex(tree.data() + partitionBase(partition), partitionSize(partition), needle, strict, compare);
+  }
+
+  /* Shared implementation of lower_bound and upper_bound. If the partition holding the needle contains no suitable
+   * element, the answer is the first element of the next non-empty partition */
+  size_t boundPartition(const T &needle, bool strict, size_t &index) const {
+    const size_t partition = partitionOf(needle);
+
+    if (partition == partitionCount()) {
+      index = 0;
+      return partition;
+    }
+
+    index = boundWithin(partition, needle, strict);
+
+    if (index == partitionSize(partition)) {
+      const size_t next = firstNonEmptyPartition(partition + 1);
+      index = ((next == partitionCount()) ? 0 : digLeft(0, partitionSize(next)));
+      return next;
+    }
+
+    return partition;
+  }
+
+  Position endPosition() const { return Position(partitionCount(), 0); }
+
+  /* One step of a descent tracking both in-order neighbours of the needle within a partition's tree: the last node at
+   * which the descent turned right is the largest element LT the needle (LTE, if strict), and the last node at which it
+   * turned left is the smallest element GTE the needle (GT, if strict) */
+  void bracketStep(const T &element, const T &needle, bool strict, size_t &index, size_t &below, size_t &above) const {
+    const bool left = (strict ? compare(needle, element) : !compare(element, needle));
 
-    leftmost = digLeft(0, tree.size());
-    rightmost = digRight(0, tree.size());
+    /* Written as selects rather than branches: the direction is unpredictable, and this compiles to conditional
+     * moves */
+    above = (left ? index : above);
+    below = (left ? below : index);
+    index = (left ? goLeft(index) : goRight(index));
   }
 
-public:
-  typedef typename Vector::const_iterator UnorderedIterator;
+  /* Translate the neighbours found within a partition (or the partition's size, where none was found) into positions
+   * in the whole set. A missing neighbour is the last element of the preceding non-empty partition, or the first of
+   * the following one; end() if there is none. The partition may be partitionCount(), for needles greater than every
+   * element */
+  void resolveBracket(size_t partition, size_t below_index, size_t above_index, Position &below,
+                      Position &above) const {
+    const size_t n = ((partition == partitionCount()) ? 0 : partitionSize(partition));
+
+    if (below_index < n) {
+      below = Position(partition, below_index);
+    } else {
+      const size_t previous = lastNonEmptyPartitionBefore(partition);
+      below = ((previous == partitionCount()) ? endPosition()
+                                              : Position(previous, digRight(0, partitionSize(previous))));
+    }
+
+    if (above_index < n) {
+      above = Position(partition, above_index);
+    } else if (partition == partitionCount()) {
+      above = endPosition();
+    } else {
+      const size_t next = firstNonEmptyPartition(partition + 1);
+      above = ((next == partitionCount()) ? endPosition() : Position(next, digLeft(0, partitionSize(next))));
+    }
+  }
+
+  /* Both in-order neighbours of the needle, in a single descent; see bracketStep */
+  void bracket(const T &needle, bool strict, Position &below, Position &above) const {
+    const size_t partition = partitionOf(needle);
+    size_t below_index = 0;
+    size_t above_index = 0;
+
+    if (partition != partitionCount()) {
+      const T *subtree = tree.data() + partitionBase(partition);
+      const size_t n = partitionSize(partition);
+
+      below_index = above_index = n;
 
+      for (size_t index = 0; index < n;) {
+        bracketStep(subtree[index], needle, strict, index, below_index, above_index);
+      }
+    }
+
+    resolveBracket(partition, below_index, above_index, below, above);
+  }
+
+  /* Choosers pick the requested neighbour of a needle from the two elements bracketing it (see bracket). Only the
+   * nearest() family measures distances, so only it requires StaticSetDistance to be defined for T */
+
+  struct ChooseBelow {
+    Position operator()(const StaticSet &, const T &, const Position &below, const Position &) const { return below; }
+  };
+
+  struct ChooseAbove {
+    Position operator()(const StaticSet &, const T &, const Position &, const Position &above) const { return above; }
+  };
+
+  /* Nearest is bracketed by the floor and the successor. The floor wins if it equals the needle, or if the two are
+   * equally near, i.e. ties go to the element that comes first in the set's order */
+  struct ChooseNearest {
+    Position operator()(const StaticSet &ss, const T &needle, const Position &below, const Position &above) const {
+      if (below == ss.endPosition() || above == ss.endPosition()) {
+        return ((below == ss.endPosition()) ? above : below);
+      }
+
+      const OrderedIterator lower(ss, below);
+      const OrderedIterator upper(ss, above);
+
+      if (!ss.compare(*lower, needle)) {
+        return below;
+      }
+
+      typedef StaticSetDistance<T> Distance;
+      return ((Distance::between(*upper, needle) < Distance::between(*lower, needle)) ? above : below);
+    }
+  };
+
+  template <class Choose> Position neighbour(const T &needle, bool strict, Choose choose) const {
+    Position below;
+    Position above;
+    bracket(needle, strict, below, above);
+    return choose(*this, needle, below, above);
+  }
+
+  /* Batched form of neighbour, writing ranks. The tree-based layouts take the needles in groups of batch_lanes and
+   * advance all of the group's descents by one level at a time; the descents are independent, so the processor can
+   * overlap their cache misses instead of serializing them */
+  template <class Iter, class Out, class Choose>
+  Out neighbourRanks(Iter first, Iter last, bool strict, Choose choose, Out out) const {
+    Iter needles[batch_lanes];
+    size_t lane_partition[batch_lanes];
+    size_t lane_base[batch_lanes];
+    size_t lane_size[batch_lanes];
+    size_t lane_index[batch_lanes];
+    size_t lane_below[batch_lanes];
+    size_t lane_above[batch_lanes];
+
+    while (first != last) {
+      size_t lanes = 0;
+
+      for (; lanes < batch_lanes && first != last; ++first, lanes++) {
+        const size_t partition = partitionOf(*first);
+        const bool beyond = (partition == partitionCount());
+
+        needles[lanes] = first;
+        lane_partition[lanes] = partition;
+        lane_base[lanes] = (beyond ? 0 : partitionBase(partition));
+        lane_size[lanes] = (beyond ? 0 : partitionSize(partition));
+        lane_index[lanes] = 0;
+        lane_below[lanes] = lane_above[lanes] = lane_size[lanes];
+      }
+
+      for (bool active = true; active;) {
+        active = false;
+
+        for (size_t lane = 0; lane < lanes; lane++) {
+          size_t index = lane_index[lane];
+
+          if (index < lane_size[lane]) {
+            const T *subtree = tree.data() + lane_base[lane];
+            bracketStep(subtree[index], *needles[lane], strict, index, lane_below[lane], lane_above[lane]);
+            prefetch(subtree + index);
+
+            lane_index[lane] = index;
+            active = true;
+          }
+        }
+      }
+
+      for (size_t lane = 0; lane < lanes; lane++) {
+        Position below;
+        Position above;
+        resolveBracket(lane_partition[lane], lane_below[lane], lane_above[lane], below, above);
+
+        *out++ = rank(OrderedIterator(*this, choose(*this, *needles[lane], below, above)));
+      }
+    }
+
+    return out;
+  }
+
+public:
   class OrderedIterator {
     friend class StaticSet;
 
     const StaticSet<T, Compare, Allocator> &ss;
+    size_t partition;
     size_t index;
 
-    OrderedIterator(const StaticSet<T, Compare, Allocator> &ss, size_t index) : ss(ss), index(index) { ; }
+    OrderedIterator(const StaticSet<T, Compare, Allocator> &ss, size_t partition, size_t index)
+        : ss(ss), partition(partition), index(index) {
+      ;
+    }
+
+    OrderedIterator(const StaticSet<T, Compare, Allocator> &ss, Position position)
+        : OrderedIterator(ss, position.first, position.second) {
+      ;
+    }
 
   public:
     typedef size_t difference_type;
@@ -143,49 +602,30 @@ public:
     typedef std::bidirectional_iterator_tag iterator_category;
 
     reference operator*() const {
-      assert(index < ss.size());
-      return ss.tree[index];
+      assert(partition < ss.partitionCount() && index < ss.partitionSize(partition));
+      return ss.tree[ss.partitionBase(partition) + index];
     }
 
-    pointer operator->() const {
-      assert(index < ss.size());
-      return &ss.tree[index];
-    }
+    pointer operator->() const { return &**this; }
 
-    bool operator==(const OrderedIterator &other) const { return (&ss == &other.ss && index == other.index); }
+    bool operator==(const OrderedIterator &other) const {
+      return (&ss == &other.ss && partition == other.partition && index == other.index);
+    }
 
     bool operator!=(const OrderedIterator &other) const { return !(*this == other); }
 
     OrderedIterator &operator++() {
-      assert(index < ss.size());
-
-      /* Three cases: (i) We're at the last element of the ordered sequence; indicate this by
-       * setting index = ss.size() + 1; (ii) We're at a node with a right subtree; the next element
-       * of the ordered sequence is the leftmost descendant of the right subtree; (iii) We're at a
-       * node with no right subtree, but (because we're not at the end of the ordered sequence) we
-       * must be in the left subtree of some ancestor; the lowest such ancestor is the next node in
-       * the ordered sequence */
-
-      if (index == ss.rightmost) {
-        /* Case (i) */
-        index = ss.size() + 1;
-      } else {
-        const size_t right = goRight(index);
-
-        if (right < ss.size()) {
-          /* Case (ii) */
-          index = digLeft(right, ss.size());
-        } else {
-          /* Case (iii) */
-          assert(index != 0);
-
-          while (!isLeft(index)) {
-            index = goUp(index);
-            assert(index != 0);
-          }
+      assert(partition < ss.partitionCount() && index < ss.partitionSize(partition));
 
-          index = goUp(index);
-        }
+      /* Having walked off the end of the partition's tree, the next element is the leftmost node of the next
+       * non-empty partition, or the end of the sequence if there is none */
+
+      const size_t n = ss.partitionSize(partition);
+      index = StaticSetTree::successor(index, n);
+
+      if (index == n) {
+        partition = ss.firstNonEmptyPartition(partition + 1);
+        index = ((partition == ss.partitionCount()) ? 0 : digLeft(0, ss.partitionSize(partition)));
       }
 
       return *this;
@@ -198,25 +638,21 @@ public:
     }
 
     OrderedIterator &operator--() {
-      assert(index != ss.leftmost && index <= 1 + ss.size());
-
-      if (index == ss.size() + 1) {
-        index = ss.rightmost;
-      } else {
-        const size_t left = goLeft(index);
+      assert(*this != ss.begin());
 
-        if (left < ss.size()) {
-          index = digRight(left, ss.size());
-        } else {
-          assert(index != 0);
+      if (partition == ss.partitionCount()) {
+        partition = ss.lastNonEmptyPartitionBefore(partition);
+        index = digRight(0, ss.partitionSize(partition));
+        return *this;
+      }
 
-          while (!isRight(index)) {
-            index = goUp(index);
-            assert(index != 0);
-          }
+      const size_t n = ss.partitionSize(partition);
+      index = StaticSetTree::predecessor(index, n);
 
-          index = goUp(index);
-        }
+      if (index == n) {
+        partition = ss.lastNonEmptyPartitionBefore(partition);
+        assert(partition != ss.partitionCount());
+        index = digRight(0, ss.partitionSize(partition));
       }
 
       return *this;
@@ -229,16 +665,37 @@ public:
     }
   };
 
-  StaticSet() { ; }
+  /* Visits every element of the set in no particular order, by a linear scan of the underlying array */
+  typedef typename Vector::const_iterator UnorderedIterator;
+
+  StaticSet() : compare() { ; }
 
   explicit StaticSet(const Compare &comp, const Allocator &alloc = Allocator()) : compare(comp), tree(alloc) { ; }
 
-  explicit StaticSet(const Allocator &alloc) : tree(alloc) { ; }
+  explicit StaticSet(const Allocator &alloc) : compare(), tree(alloc) { ; }
 
   template <class Iter>
   StaticSet(Iter first, Iter last, const Compare &comp = Compare(), const Allocator &alloc = Allocator())
       : compare(comp), tree(alloc) {
-    initialize(Vector(first, last));
+    initialize(Vector(first, last, alloc));
+  }
+
+  template <class Iter>
+  StaticSet(Iter first, Iter last, StaticSetLayout layout, const Compare &comp = Compare(),
+            const Allocator &alloc = Allocator())
+      : compare(comp), tree(alloc) {
+    initialize(Vector(first, last, alloc), layout);
+  }
+
+  /* Takes ownership of the given elements; nothing is copied */
+  explicit StaticSet(std::vector<T, Allocator> &&values, const Compare &comp = Compare())
+      : compare(comp), tree(values.get_allocator()) {
+    initialize(std::move(values));
+  }
+
+  StaticSet(std::vector<T, Allocator> &&values, StaticSetLayout layout, const Compare &comp = Compare())
+      : compare(comp), tree(values.get_allocator()) {
+    initialize(std::move(values), layout);
   }
 
   StaticSet(std::initializer_list<T> list, const Compare &comp = Compare(), const Allocator &alloc = Allocator())
@@ -246,27 +703,77 @@ public:
     initialize(Vector(list, alloc));
   }
 
+  StaticSet(std::initializer_list<T> list, StaticSetLayout layout, const Compare &comp = Compare(),
+            const Allocator &alloc = Allocator())
+      : compare(comp), tree(alloc) {
+    initialize(Vector(list, alloc), layout);
+  }
+
   StaticSet(const StaticSet &other) = default;
 
-  StaticSet(StaticSet &&other) = default;
+private:
+  /* Tags the constructor for elements which are already sorted and free of duplicates, as StaticMultiSet and
+   * StaticAggregateMap have them, having sorted them to gather multiplicities or values */
+  struct SortedUnique {};
+
+  StaticSet(std::vector<T, Allocator> &&sorted, StaticSetLayout layout, const Compare &comp, SortedUnique)
+      : compare(comp), tree(sorted.get_allocator()) {
+    build(sorted.begin(), sorted.end(), layout);
+  }
+
+public:
+
+  StaticSet(StaticSet &&other)
+      : compare(other.compare), tree(std::move(other.tree)), chosen_layout(other.chosen_layout),
+        partitions(std::move(other.partitions)), radix_low(other.radix_low), radix_high(other.radix_high),
+        radix_shift(other.radix_shift) {
+    other.reset();
+  }
 
   StaticSet<T, Compare, Allocator> &operator=(const StaticSet<T, Compare, Allocator> &other) = default;
 
-  StaticSet<T, Compare, Allocator> &operator=(StaticSet<T, Compare, Allocator> &&other) = default;
+  StaticSet<T, Compare, Allocator> &operator=(StaticSet<T, Compare, Allocator> &&other) {
+    if (this != &other) {
+      compare = other.compare;
+      tree = std::move(other.tree);
+      chosen_layout = other.chosen_layout;
+      partitions = std::move(other.partitions);
+      radix_low = other.radix_low;
+      radix_high = other.radix_high;
+      radix_shift = other.radix_shift;
+      other.reset();
+    }
+    return *this;
+  }
 
-  StaticSet<T, Compare, Allocator> &operator=(std::initializer_list<T> list) { initialize(Vector(list)); }
+  StaticSet<T, Compare, Allocator> &operator=(std::initializer_list<T> list) {
+    initialize(Vector(list, tree.get_allocator()));
+    return *this;
+  }
 
   size_t size() const { return tree.size(); }
 
-  bool empty() const { return tree.empty(); }
+  bool empty() const { return (size() == 0); }
 
   Compare valueComp() const { return compare; }
 
   Compare value_comp() const { return valueComp(); }
 
-  OrderedIterator begin() const { return OrderedIterator(*this, ((size() == 0) ? 1 : leftmost)); }
+  /* The layout actually in use; never Automatic */
+  StaticSetLayout layout() const { return chosen_layout; }
+
+  /* The number of bytes of heap storage used to represent the elements of the set */
+  size_t memoryUsage() const {
+    return (tree.size() * sizeof(T) + partitions.size() * sizeof(size_t));
+  }
+
+  OrderedIterator begin() const {
+    const size_t partition = firstNonEmptyPartition(0);
+    const size_t index = ((partition == partitionCount()) ? 0 : digLeft(0, partitionSize(partition)));
+    return OrderedIterator(*this, partition, index);
+  }
 
-  OrderedIterator end() const { return OrderedIterator(*this, size() + 1); }
+  OrderedIterator end() const { return OrderedIterator(*this, partitionCount(), 0); }
 
   UnorderedIterator ubegin() const { return tree.cbegin(); }
 
@@ -282,47 +789,94 @@ public:
   }
 
   OrderedIterator lower_bound(const T &needle) const {
-    size_t index = 0;
-    size_t best = size() + 1;
-
-    while (index < size()) {
-      if (compare(needle, tree[index])) {
-        best = index;
-        index = goLeft(index);
-      } else if (compare(tree[index], needle)) {
-        index = goRight(index);
-      } else {
-        best = index;
-        break;
-      }
-    }
+    size_t index;
+    const size_t partition = boundPartition(needle, false, index);
+    const OrderedIterator iterator(*this, partition, index);
 
-    assert(best == size() + 1 || !compare(tree[best], needle));
+    assert(iterator == end() || !compare(*iterator, needle));
 
-    return OrderedIterator(*this, best);
+    return iterator;
   }
 
   OrderedIterator lowerBound(const T &needle) const { return lower_bound(needle); }
 
   OrderedIterator upper_bound(const T &needle) const {
-    size_t index = 0;
-    size_t best = size() + 1;
-
-    while (index < size()) {
-      if (compare(needle, tree[index])) {
-        best = index;
-        index = goLeft(index);
-      } else {
-        index = goRight(index);
-      }
-    }
+    size_t index;
+    const size_t partition = boundPartition(needle, true, index);
+    const OrderedIterator iterator(*this, partition, index);
 
-    assert(best == size() + 1 || compare(needle, tree[best]));
+    assert(iterator == end() || compare(needle, *iterator));
 
-    return OrderedIterator(*this, best);
+    return iterator;
   }
 
   OrderedIterator upperBound(const T &needle) const { return upper_bound(needle); }
+
+  /* The in-order neighbours of a value, each found in a single descent that tracks both bracketing candidates, rather
+   * than a bound followed by a step of the iterator. Each returns end() if there is no such element */
+
+  /* The largest element LT the needle */
+  OrderedIterator predecessor(const T &needle) const {
+    return OrderedIterator(*this, neighbour(needle, false, ChooseBelow()));
+  }
+
+  /* The smallest element GT the needle; equivalent to upper_bound */
+  OrderedIterator successor(const T &needle) const {
+    return OrderedIterator(*this, neighbour(needle, true, ChooseAbove()));
+  }
+
+  /* The largest element LTE the needle */
+  OrderedIterator floor(const T &needle) const {
+    return OrderedIterator(*this, neighbour(needle, true, ChooseBelow()));
+  }
+
+  /* The smallest element GTE the needle; equivalent to lower_bound */
+  OrderedIterator ceiling(const T &needle) const {
+    return OrderedIterator(*this, neighbour(needle, false, ChooseAbove()));
+  }
+
+  /* The element nearest the needle by value (see StaticSetDistance). Of two equidistant elements, prefers the one
+   * that comes first in the set's order, i.e. the smaller under std::less */
+  OrderedIterator nearest(const T &needle) const {
+    return OrderedIterator(*this, neighbour(needle, true, ChooseNearest()));
+  }
+
+  /* Batched neighbour queries. For each needle in [first, last), which must be a forward range, writes the rank of the
+   * corresponding neighbour (see rank()) to out, or size() if there is none; returns the advanced output iterator.
+   * Descents are interleaved, so a batch completes considerably faster than the same queries made one at a time */
+
+  template <class Iter, class Out> Out predecessorRanks(Iter first, Iter last, Out out) const {
+    return neighbourRanks(first, last, false, ChooseBelow(), out);
+  }
+
+  template <class Iter, class Out> Out successorRanks(Iter first, Iter last, Out out) const {
+    return neighbourRanks(first, last, true, ChooseAbove(), out);
+  }
+
+  template <class Iter, class Out> Out floorRanks(Iter first, Iter last, Out out) const {
+    return neighbourRanks(first, last, true, ChooseBelow(), out);
+  }
+
+  template <class Iter, class Out> Out ceilingRanks(Iter first, Iter last, Out out) const {
+    return neighbourRanks(first, last, false, ChooseAbove(), out);
+  }
+
+  template <class Iter, class Out> Out nearestRanks(Iter first, Iter last, Out out) const {
+    return neighbourRanks(first, last, true, ChooseNearest(), out);
+  }
+
+  /* The number of elements less than the one at the given position, i.e. its position in the ordered sequence; size()
+   * for end(). Constant time for every layout, which makes it suitable for indexing data kept alongside the set in
+   * sorted order */
+  size_t rank(const OrderedIterator &iterator) const {
+    assert(&iterator.ss == this);
+
+    if (iterator == end()) {
+      return size();
+    }
+
+    return partitionBase(iterator.partition) + StaticSetTree::rank(iterator.index, partitionSize(iterator.partition));
+  }
 };
 
 #endif
@@ -0,0 +1,324 @@
+#ifndef LIBSTATICSET_STATICTUPLESET_H
+#define LIBSTATICSET_STATICTUPLESET_H
+
+#include "staticset.h"
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/* Orders a key value against a column value. Integers of different types are compared by value, rather than after
+ * the usual arithmetic conversions, which would turn negative values into huge unsigned ones */
+template <class X, class Y, class Enable = void> struct StaticTupleLess {
+  static bool less(const X &x, const Y &y) { return (x < y); }
+};
+
+template <class X, class Y>
+struct StaticTupleLess<X, Y,
+                       typename std::enable_if<std::is_integral<X>::value && std::is_integral<Y>::value &&
+                                               !std::is_same<X, Y>::value>::type> {
+  template <class Z> static typename std::enable_if<std::is_signed<Z>::value, bool>::type negative(Z z) {
+    return (z < 0);
+  }
+
+  template <class Z> static typename std::enable_if<!std::is_signed<Z>::value, bool>::type negative(Z) {
+    return false;
+  }
+
+  static bool less(X x, Y y) {
+    if (negative(x) != negative(y)) {
+      return negative(x);
+    }
+
+    return (negative(x) ? static_cast<intmax_t>(x) < static_cast<intmax_t>(y)
+                        : static_cast<uintmax_t>(x) < static_cast<uintmax_t>(y));
+  }
+};
+
+/* The key for a query on the leading columns of tuples of the given type, holding the given values. Each value is
+ * converted to its column's type once, up front, rather than on every comparison; arithmetic values are kept as they
+ * are, since converting them could change them, e.g. truncating 2.5 to 2 or wrapping -1 to the largest unsigned */
+template <class Columns, class Values, class Key = std::tuple<>> struct StaticTuplePrefixKey;
+
+template <class Column, class... Columns, class Value, class... Values, class... Keys>
+struct StaticTuplePrefixKey<std::tuple<Column, Columns...>, std::tuple<Value, Values...>, std::tuple<Keys...>>
+    : StaticTuplePrefixKey<std::tuple<Columns...>, std::tuple<Values...>,
+                           std::tuple<Keys..., typename std::conditional<std::is_arithmetic<Value>::value &&
+                                                                             std::is_arithmetic<Column>::value,
+                                                                         Value, Column>::type>> {};
+
+template <class... Columns, class... Keys>
+struct StaticTuplePrefixKey<std::tuple<Columns...>, std::tuple<>, std::tuple<Keys...>> {
+  typedef std::tuple<Keys...> type;
+};
+
+/* Column-wise operations on tuples, for columns [I, N) */
+template <size_t I, size_t N> struct StaticTupleColumns {
+  /* Three-way lexicographic comparison of key against the tuple at the given index: negative if key is less, positive
+   * if it is greater. Later columns are read only when all earlier ones compare equal */
+  template <class Columns, class Key> static int compare(const Columns &columns, size_t index, const Key &key) {
+    typedef typename std::tuple_element<I, Key>::type KeyValue;
+    typedef typename std::tuple_element<I, Columns>::type::value_type ColumnValue;
+
+    const auto &value = std::get<I>(columns)[index];
+
+    if (StaticTupleLess<KeyValue, ColumnValue>::less(std::get<I>(key), value)) {
+      return -1;
+    }
+
+    if (StaticTupleLess<ColumnValue, KeyValue>::less(value, std::get<I>(key))) {
+      return 1;
+    }
+
+    return StaticTupleColumns<I + 1, N>::compare(columns, index, key);
+  }
+
+  template <class Columns> static void reserve(Columns &columns, size_t size) {
+    std::get<I>(columns).reserve(size);
+    StaticTupleColumns<I + 1, N>::reserve(columns, size);
+  }
+
+  template <class Columns, class Tuple> static void append(Columns &columns, Tuple &tuple) {
+    std::get<I>(columns).push_back(std::move(std::get<I>(tuple)));
+    StaticTupleColumns<I + 1, N>::append(columns, tuple);
+  }
+
+  template <class Columns, class Tuple> static void load(const Columns &columns, size_t index, Tuple &tuple) {
+    std::get<I>(tuple) = std::get<I>(columns)[index];
+    StaticTupleColumns<I + 1, N>::load(columns, index, tuple);
+  }
+};
+
+template <size_t N> struct StaticTupleColumns<N, N> {
+  template <class Columns, class Key> static int compare(const Columns &, size_t, const Key &) { return 0; }
+
+  template <class Columns> static void reserve(Columns &, size_t) { ; }
+
+  template <class Columns, class Tuple> static void append(Columns &, Tuple &) { ; }
+
+  template <class Columns, class Tuple> static void load(const Columns &, size_t, Tuple &) { ; }
+};
+
+/* A static set of tuples, ordered lexicographically, with each column stored in its own Eytzinger-ordered array. Most
+ * comparisons during a descent are settled by the leading column alone, so a lookup mostly touches one densely-packed
+ * array rather than padded tuples. Queries on a prefix of the columns, e.g. all tuples whose first column equals x,
+ * are answered directly, without manufacturing the smallest and largest tuples sharing that prefix */
+template <class... Ts> class StaticTupleSet : private StaticSetTree {
+public:
+  typedef std::tuple<Ts...> value_type;
+
+private:
+  static const size_t column_count = sizeof...(Ts);
+
+  typedef std::tuple<std::vector<Ts>...> Columns;
+
+  Columns columns;
+  size_t n;
+
+  template <class... Prefix>
+  static typename StaticTuplePrefixKey<value_type, std::tuple<Prefix...>>::type prefixKey(const Prefix &... prefix) {
+    return typename StaticTuplePrefixKey<value_type, std::tuple<Prefix...>>::type(prefix...);
+  }
+
+  template <class Key> static int compareAt(const Columns &columns, size_t index, const Key &key) {
+    return StaticTupleColumns<0, std::tuple_size<Key>::value>::compare(columns, index, key);
+  }
+
+  /* Index of the smallest tuple GTE the key (or GT the key, if strict), or n if no such tuple exists. The key may be a
+   * prefix of a tuple, in which case only the leading columns are compared */
+  template <class Key> size_t bound(const Key &key, bool strict) const {
+    size_t index = 0;
+    size_t best = n;
+
+    while (index < n) {
+      const int order = compareAt(columns, index, key);
+
+      if (order < 0 || (order == 0 && !strict)) {
+        best = index;
+        index = goLeft(index);
+      } else {
+        index = goRight(index);
+      }
+    }
+
+    return best;
+  }
+
+  /* Indices of the smallest tuple GTE the key and the smallest tuple GT the key, in a single descent: the two searches
+   * follow the same path until they reach a tuple equal to the key, whereupon they continue into its left and right
+   * subtrees respectively */
+  template <class Key> std::pair<size_t, size_t> bounds(const Key &key) const {
+    size_t index = 0;
+    size_t upper = n;
+    int order = 0;
+
+    while (index < n && (order = compareAt(columns, index, key)) != 0) {
+      if (order < 0) {
+        upper = index;
+        index = goLeft(index);
+      } else {
+        index = goRight(index);
+      }
+    }
+
+    if (index >= n) {
+      return std::make_pair(upper, upper);
+    }
+
+    size_t lower = index;
+
+    for (size_t left = goLeft(index); left < n;) {
+      if (compareAt(columns, left, key) <= 0) {
+        lower = left;
+        left = goLeft(left);
+      } else {
+        left = goRight(left);
+      }
+    }
+
+    for (size_t right = goRight(index); right < n;) {
+      if (compareAt(columns, right, key) < 0) {
+        upper = right;
+        right = goLeft(right);
+      } else {
+        right = goRight(right);
+      }
+    }
+
+    return std::make_pair(lower, upper);
+  }
+
+  void initialize(std::vector<value_type> scratch) {
+    std::sort(scratch.begin(), scratch.end());
+    scratch.erase(std::unique(scratch.begin(), scratch.end()), scratch.end());
+
+    n = scratch.size();
+    StaticTupleColumns<0, column_count>::reserve(columns, n);
+
+    for (size_t index = 0; index < n; index++) {
+      StaticTupleColumns<0, column_count>::append(columns, scratch[rank(index, n)]);
+    }
+  }
+
+public:
+  class OrderedIterator {
+    friend class StaticTupleSet;
+
+    const StaticTupleSet<Ts...> *ts;
+    size_t index;
+
+    OrderedIterator(const StaticTupleSet<Ts...> &ts, size_t index) : ts(&ts), index(index) { ; }
+
+  public:
+    typedef size_t difference_type;
+    typedef std::tuple<Ts...> value_type;
+    typedef void pointer;
+    typedef value_type reference;
+    typedef std::bidirectional_iterator_tag iterator_category;
+
+    /* Tuples are assembled from the columns on demand, hence returned by value */
+    value_type operator*() const {
+      assert(index < ts->n);
+      value_type tuple;
+      StaticTupleColumns<0, column_count>::load(ts->columns, index, tuple);
+      return tuple;
+    }
+
+    /* A single column of the current tuple, read without assembling the rest. A bool column is a bit-packed
+     * std::vector<bool>, which has no element to refer to, so is read by value */
+    template <size_t I>
+    typename std::conditional<std::is_same<typename std::tuple_element<I, value_type>::type, bool>::value, bool,
+                              const typename std::tuple_element<I, value_type>::type &>::type
+    get() const {
+      assert(index < ts->n);
+      return std::get<I>(ts->columns)[index];
+    }
+
+    bool operator==(const OrderedIterator &other) const { return (ts == other.ts && index == other.index); }
+
+    bool operator!=(const OrderedIterator &other) const { return !(*this == other); }
+
+    OrderedIterator &operator++() {
+      assert(index < ts->n);
+      index = successor(index, ts->n);
+      return *this;
+    }
+
+    OrderedIterator operator++(int) {
+      OrderedIterator prev = *this;
+      ++(*this);
+      return prev;
+    }
+
+    OrderedIterator &operator--() {
+      assert(*this != ts->begin());
+      index = ((index == ts->n) ? digRight(0, ts->n) : predecessor(index, ts->n));
+      return *this;
+    }
+
+    OrderedIterator operator--(int) {
+      OrderedIterator prev = *this;
+      --(*this);
+      return prev;
+    }
+  };
+
+  StaticTupleSet() : n(0) { ; }
+
+  template <class Iter> StaticTupleSet(Iter first, Iter last) : n(0) {
+    initialize(std::vector<value_type>(first, last));
+  }
+
+  StaticTupleSet(std::initializer_list<value_type> list) : n(0) { initialize(std::vector<value_type>(list)); }
+
+  explicit StaticTupleSet(std::vector<value_type> &&values) : n(0) { initialize(std::move(values)); }
+
+  size_t size() const { return n; }
+
+  bool empty() const { return (n == 0); }
+
+  OrderedIterator begin() const { return OrderedIterator(*this, ((n == 0) ? 0 : digLeft(0, n))); }
+
+  OrderedIterator end() const { return OrderedIterator(*this, n); }
+
+  bool contains(const value_type &needle) const { return (find(needle) != end()); }
+
+  OrderedIterator find(const value_type &needle) const {
+    const size_t index = bound(needle, false);
+    return ((index == n || compareAt(columns, index, needle) != 0) ? end() : OrderedIterator(*this, index));
+  }
+
+  OrderedIterator lower_bound(const value_type &needle) const { return OrderedIterator(*this, bound(needle, false)); }
+
+  OrderedIterator lowerBound(const value_type &needle) const { return lower_bound(needle); }
+
+  OrderedIterator upper_bound(const value_type &needle) const { return OrderedIterator(*this, bound(needle, true)); }
+
+  OrderedIterator upperBound(const value_type &needle) const { return upper_bound(needle); }
+
+  /* The range of tuples whose leading columns equal the given values, e.g. equal_range_prefix(x) for all tuples whose
+   * first column is x */
+  template <class... Prefix>
+  std::pair<OrderedIterator, OrderedIterator> equal_range_prefix(const Prefix &... prefix) const {
+    static_assert(sizeof...(Prefix) <= sizeof...(Ts), "prefix has more columns than the tuples");
+
+    const std::pair<size_t, size_t> range = bounds(prefixKey(prefix...));
+    return std::make_pair(OrderedIterator(*this, range.first), OrderedIterator(*this, range.second));
+  }
+
+  template <class... Prefix>
+  std::pair<OrderedIterator, OrderedIterator> equalRangePrefix(const Prefix &... prefix) const {
+    return equal_range_prefix(prefix...);
+  }
+
+  /* The number of tuples whose leading columns equal the given values */
+  template <class... Prefix> size_t countPrefix(const Prefix &... prefix) const {
+    static_assert(sizeof...(Prefix) <= sizeof...(Ts), "prefix has more columns than the tuples");
+
+    const std::pair<size_t, size_t> range = bounds(prefixKey(prefix...));
+    return ((range.second == n) ? n : rank(range.second, n)) - ((range.first == n) ? n : rank(range.first, n));
+  }
+};
+
+#endif
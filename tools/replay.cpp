@@ -0,0 +1,228 @@
+#include "externalstaticset.h"
+#include "querytrace.h"
+#include "staticbitmapset.h"
+#include "staticset.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+/* Replays a query trace (see querytrace.h) against a snapshot of the set it was recorded from, once per layout, and
+ * reports latency percentiles and throughput. By default queries are issued back to back, and timed in batches: reading
+ * the clock around each query would cost as much as the query itself, so the percentiles are of each batch's mean
+ * latency. With --paced, each query is held until its recorded offset from the start of the trace, reproducing the
+ * original arrival rate, and is timed individually */
+
+/* Unpaced replays read the clock once per this many queries */
+static const size_t batch_size = 256;
+
+static const char *layoutName(StaticSetLayout layout) {
+  switch (layout) {
+  case StaticSetLayout::Automatic:
+    return "automatic";
+  case StaticSetLayout::Tree:
+    return "tree";
+  case StaticSetLayout::Partitioned:
+    return "partitioned";
+  }
+  return "?";
+}
+
+static uint64_t percentile(const std::vector<uint64_t> &sorted, double fraction) {
+  return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+}
+
+template <class Set, class T> static size_t execute(const Set &ss, const QueryTraceRecord<T> &record) {
+  switch (record.op) {
+  case QueryOp::Contains:
+    return ss.contains(record.key);
+  case QueryOp::Find:
+    return ss.rank(ss.find(record.key));
+  case QueryOp::LowerBound:
+    return ss.rank(ss.lower_bound(record.key));
+  case QueryOp::UpperBound:
+    return ss.rank(ss.upper_bound(record.key));
+  case QueryOp::Predecessor:
+    return ss.rank(ss.predecessor(record.key));
+  case QueryOp::Successor:
+    return ss.rank(ss.successor(record.key));
+  case QueryOp::Floor:
+    return ss.rank(ss.floor(record.key));
+  case QueryOp::Ceiling:
+    return ss.rank(ss.ceiling(record.key));
+  case QueryOp::Nearest:
+    return ss.rank(ss.nearest(record.key));
+  }
+  return 0;
+}
+
+/* Replay the trace against one representation of the set, print its row of the report and return its checksum */
+template <class Set, class T>
+static size_t replayAgainst(const std::string &name, const Set &ss, const std::vector<QueryTraceRecord<T>> &records,
+                            bool paced) {
+  typedef std::chrono::steady_clock Clock;
+
+  std::vector<uint64_t> latencies;
+  latencies.reserve(paced ? records.size() : records.size() / batch_size + 1);
+
+  size_t checksum = 0;
+  const Clock::time_point started = Clock::now();
+
+  if (paced) {
+    for (const QueryTraceRecord<T> &record : records) {
+      /* Latency is measured from when the query was due rather than when it was issued, so that time spent queued
+       * behind slow queries is counted */
+      const Clock::time_point due = started + std::chrono::nanoseconds(record.timestamp);
+      while (Clock::now() < due) {
+        ;
+      }
+
+      checksum += execute(ss, record);
+
+      latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due).count());
+    }
+  } else {
+    Clock::time_point issued = started;
+
+    for (size_t first = 0; first < records.size(); first += batch_size) {
+      const size_t last = std::min(records.size(), first + batch_size);
+
+      for (size_t i = first; i < last; i++) {
+        checksum += execute(ss, records[i]);
+      }
+
+      const Clock::time_point finished = Clock::now();
+      latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(finished - issued).count() /
+                          (last - first));
+      issued = finished;
+    }
+  }
+
+  const double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+
+  std::sort(latencies.begin(), latencies.end());
+
+  std::printf("%-18s %10llu %10llu %10llu %10llu %10llu %14.0f\n", name.c_str(),
+              static_cast<unsigned long long>(percentile(latencies, 0.5)),
+              static_cast<unsigned long long>(percentile(latencies, 0.9)),
+              static_cast<unsigned long long>(percentile(latencies, 0.99)),
+              static_cast<unsigned long long>(percentile(latencies, 0.999)),
+              static_cast<unsigned long long>(latencies.back()), records.size() / elapsed);
+
+  return checksum;
+}
+
+template <class T> static int replay(const std::string &snapshot, const std::string &trace, bool paced) {
+  const MappedStaticSet<T> mapped(snapshot);
+  const std::vector<T> elements(mapped.begin(), mapped.end());
+
+  /* Snapshots don't record their comparator, so make sure this one was ordered as the sets rebuilt from it will be */
+  if (!std::is_sorted(elements.begin(), elements.end())) {
+    throw std::runtime_error(snapshot + ": snapshot isn't ordered by std::less");
+  }
+  const std::vector<QueryTraceRecord<T>> records = readQueryTrace<T>(trace);
+
+  std::printf("%zu elements, %zu queries over %.3f s%s\n", elements.size(), records.size(),
+              (records.empty() ? 0.0 : records.back().timestamp / 1e9), (paced ? ", paced" : ""));
+
+  if (records.empty()) {
+    return 0;
+  }
+
+  std::printf("%-18s %10s %10s %10s %10s %10s %14s\n", "layout", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns",
+              "queries/s");
+
+  const StaticSetLayout layouts[] = {StaticSetLayout::Automatic, StaticSetLayout::Tree, StaticSetLayout::Partitioned};
+
+  size_t expected_checksum = 0;
+
+  for (const StaticSetLayout layout : layouts) {
+    const StaticSet<T> ss(elements.begin(), elements.end(), layout);
+
+    if (layout != StaticSetLayout::Automatic && ss.layout() != layout) {
+      std::printf("%-18s (unavailable for this set)\n", layoutName(layout));
+      continue;
+    }
+
+    const std::string name = ((layout == StaticSetLayout::Automatic)
+                                  ? std::string(layoutName(layout)) + "=" + layoutName(ss.layout())
+                                  : std::string(layoutName(layout)));
+
+    const size_t checksum = replayAgainst(name, ss, records, paced);
+
+    if (layout == StaticSetLayout::Automatic) {
+      expected_checksum = checksum;
+    } else if (checksum != expected_checksum) {
+      std::fprintf(stderr, "replay: %s layout disagrees with %s\n", layoutName(layout),
+                   layoutName(StaticSetLayout::Automatic));
+      return 1;
+    }
+  }
+
+  std::unique_ptr<StaticBitmapSet<T>> bitmap;
+  try {
+    bitmap.reset(new StaticBitmapSet<T>(elements.begin(), elements.end()));
+  } catch (const std::invalid_argument &) {
+    std::printf("%-18s (unavailable for this set)\n", "bitmap");
+    return 0;
+  }
+
+  if (replayAgainst("bitmap", *bitmap, records, paced) != expected_checksum) {
+    std::fprintf(stderr, "replay: bitmap disagrees with %s\n", layoutName(StaticSetLayout::Automatic));
+    return 1;
+  }
+
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  bool paced = false;
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--paced") == 0) {
+      paced = true;
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+
+  if (paths.size() != 2) {
+    std::fprintf(stderr, "usage: %s [--paced] <snapshot> <trace>\n", argv[0]);
+    return 2;
+  }
+
+  try {
+    const QueryTraceHeader header = readQueryTraceHeader(paths[1]);
+
+    switch (header.key_kind) {
+    case QueryTraceKeyKind::Signed:
+      if (header.key_size == sizeof(int32_t)) {
+        return replay<int32_t>(paths[0], paths[1], paced);
+      } else if (header.key_size == sizeof(int64_t)) {
+        return replay<int64_t>(paths[0], paths[1], paced);
+      }
+      break;
+    case QueryTraceKeyKind::Unsigned:
+      if (header.key_size == sizeof(uint32_t)) {
+        return replay<uint32_t>(paths[0], paths[1], paced);
+      } else if (header.key_size == sizeof(uint64_t)) {
+        return replay<uint64_t>(paths[0], paths[1], paced);
+      }
+      break;
+    default:
+      break;
+    }
+
+    std::fprintf(stderr, "replay: unsupported key type (%u bytes)\n", header.key_size);
+    return 1;
+  } catch (const std::exception &error) {
+    std::fprintf(stderr, "replay: %s\n", error.what());
+    return 1;
+  }
+}